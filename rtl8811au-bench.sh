@@ -0,0 +1,268 @@
+#!/bin/bash
+
+# Throughput and latency benchmark for the rtl8811au driver against the emulated
+# adapter (rtl8811au_emu.ko on dummy_hcd). Run as root, normally through `make bench`.
+#
+# Tests:
+#   tx_flood  pktgen floods at each size in BENCH_SIZES, loopback off
+#   rx_flood  emulator-generated RX traffic at each size in BENCH_SIZES
+#   ping      ping-pong through the emulator's ICMP reflector
+#
+# Results (pps, Mbps, CPU ns/packet, per-handler ns from handler_timing, p50/p99
+# latency, ethtool -S after each test) are written as JSON to BENCH_OUT.
+
+set -euo pipefail
+
+# Variables (override from the environment)
+SRC_DIR="$(cd "$(dirname "$0")" && pwd)"
+BENCH_OUT="${BENCH_OUT:-$SRC_DIR/bench-results.json}"
+BENCH_DURATION="${BENCH_DURATION:-10}"          # Seconds per flood test
+BENCH_SIZES="${BENCH_SIZES:-64 512 1500}"       # Frame sizes (bytes on the Ethernet side)
+BENCH_RX_PPS="${BENCH_RX_PPS:-2000000}"         # Offered RX flood rate
+BENCH_PINGS="${BENCH_PINGS:-2000}"              # Ping-pong samples
+BENCH_PING_INTERVAL="${BENCH_PING_INTERVAL:-0.001}"
+BENCH_TIMING="${BENCH_TIMING:-1}"               # Per-handler timing (adds a little CPU per call)
+
+DRIVER="rtl8811au_wifi"                         # usb_driver name in rtl8811au.c
+FIRMWARE="/lib/firmware/rtl8811au/rtl8811au_fw.bin"
+EMU_PARAMS="/sys/module/rtl8811au_emu/parameters"
+DRV_PARAMS="/sys/module/rtl8811au/parameters"
+EMU="$SRC_DIR/rtl8811au-emu.sh"
+EMU_STATS="/sys/kernel/debug/rtl8811au_emu/0/stats" # Adapter 0, the only one
+LOCAL_IP="10.88.0.1"
+PEER_IP="10.88.0.2"
+PEER_MAC="02:88:11:a0:00:02"
+CLK_TCK="$(getconf CLK_TCK)"
+
+LOADED_DUMMY_HCD=0
+CREATED_FIRMWARE=0
+IFACE=""
+RESULTS=()
+
+die() {
+    echo "bench: $*" >&2
+    exit 1
+}
+
+cleanup() {
+    set +e
+    [ -w /proc/net/pktgen/pgctrl ] && echo stop > /proc/net/pktgen/pgctrl 2>/dev/null
+    [ -d /sys/module/rtl8811au_emu ] && "$EMU" destroy 2>/dev/null
+    rmmod rtl8811au 2>/dev/null
+    rmmod rtl8811au_emu 2>/dev/null
+    [ "$LOADED_DUMMY_HCD" = 1 ] && rmmod dummy_hcd 2>/dev/null
+    [ "$CREATED_FIRMWARE" = 1 ] && rm -f "$FIRMWARE"
+}
+
+emu_set() {
+    echo "$2" > "$EMU_PARAMS/$1"
+}
+
+pg() {
+    echo "$2" > "/proc/net/pktgen/$1"
+}
+
+# Busy CPU ticks across all CPUs (everything except idle and iowait)
+cpu_busy() {
+    awk '/^cpu / { print $2 + $3 + $4 + $7 + $8 + $9 }' /proc/stat
+}
+
+# CPU ticks used by the TX kthread of $IFACE's adapter
+tx_thread_ticks() {
+    local pid
+    pid="$(pgrep '^r8811tx/' | head -n 1 || true)"
+    if [ -n "$pid" ]; then
+        awk '{ print $14 + $15 }' "/proc/$pid/stat"
+    else
+        echo 0
+    fi
+}
+
+stat_of() {
+    cat "/sys/class/net/$IFACE/statistics/$1"
+}
+
+# ethtool -S as a JSON object
+ethtool_json() {
+    ethtool -S "$IFACE" | awk -F': *' 'NR > 1 { gsub(/^ +/, "", $1); printf "%s\"%s\": %s", sep, $1, $2; sep = ", " } END { print "" }' |
+        sed 's/^/{/; s/$/}/'
+}
+
+# prof_* handler timing counters as "name value" lines
+prof_snapshot() {
+    ethtool -S "$IFACE" | awk -F': *' '/prof_/ { gsub(/^ +/, "", $1); print $1, $2 }'
+}
+
+# Handler cost between two prof_snapshot outputs, e.g. {"xmit_ns_per_pkt": 812, ...}
+prof_json() {
+    awk 'NR == FNR { a[$1] = $2; next } { d[$1] = $2 - a[$1] }
+        END {
+            printf "{"
+            for (k in d) {
+                if (k !~ /_ns$/)
+                    continue
+                base = substr(k, 1, length(k) - 3)
+                for (u in d) {
+                    if (u ~ /_ns$/ || index(u, base "_") != 1)
+                        continue
+                    unit = substr(u, length(base) + 2); sub(/s$/, "", unit)
+                    printf "%s\"%s_ns_per_%s\": %.0f", sep, substr(base, 6), unit, d[u] ? d[k] / d[u] : 0
+                    sep = ", "
+                }
+            }
+            print "}"
+        }' <(echo "$1") <(echo "$2")
+}
+
+emu_json() {
+    [ -r "$EMU_STATS" ] || { echo "{}"; return; } # debugfs not mounted
+    awk -F': ' '{ printf "%s\"%s\": %s", sep, $1, $2; sep = ", " } END { print "" }' "$EMU_STATS" |
+        sed 's/^/{/; s/$/}/'
+}
+
+# Print a JSON result for one flood test:
+#   name size dir packets bytes busy_ticks thread_ticks prof_before prof_after
+flood_json() {
+    awk -v name="$1" -v size="$2" -v pkts="$4" -v bytes="$5" -v busy="$6" -v thr="$7" \
+        -v dur="$BENCH_DURATION" -v hz="$CLK_TCK" 'BEGIN {
+        pps = pkts / dur
+        cpu = pkts ? busy * 1e9 / hz / pkts : 0
+        tcpu = pkts ? thr * 1e9 / hz / pkts : 0
+        printf "{\"test\": \"%s\", \"size\": %d, \"packets\": %d, \"pps\": %.0f, \"mbps\": %.2f, ", name, size, pkts, pps, bytes * 8 / dur / 1e6
+        printf "\"cpu_ns_per_pkt\": %.0f, \"tx_thread_ns_per_pkt\": %.0f", cpu, tcpu
+    }'
+    printf ', "handlers": %s, "ethtool": %s, "emu": %s}' "$(prof_json "$8" "$9")" "$(ethtool_json)" "$(emu_json)"
+}
+
+setup() {
+    [ "$(id -u)" = 0 ] || die "must run as root"
+    [ -f "$SRC_DIR/rtl8811au.ko" ] && [ -f "$SRC_DIR/rtl8811au_emu.ko" ] ||
+        die "build first (the emulator needs a kernel with CONFIG_USB_LIBCOMPOSITE)"
+    command -v ethtool > /dev/null || die "ethtool not found"
+
+    trap cleanup EXIT
+
+    if ! lsmod | grep -q '^dummy_hcd'; then
+        modprobe dummy_hcd || die "dummy_hcd not available"
+        LOADED_DUMMY_HCD=1
+    fi
+    # The driver requests firmware in probe but does not upload it yet; any file will do
+    if [ ! -e "$FIRMWARE" ]; then
+        mkdir -p "$(dirname "$FIRMWARE")"
+        head -c 16 /dev/zero > "$FIRMWARE"
+        CREATED_FIRMWARE=1
+    fi
+
+    insmod "$SRC_DIR/rtl8811au_emu.ko"
+    insmod "$SRC_DIR/rtl8811au.ko"
+    "$EMU" create 1
+    if [ "$BENCH_TIMING" = 1 ]; then
+        echo 1 > "$DRV_PARAMS/handler_timing"
+    fi
+
+    for _ in $(seq 50); do
+        for dev in /sys/bus/usb/drivers/$DRIVER/*/net/*; do
+            [ -e "$dev" ] && IFACE="$(basename "$dev")" && break
+        done
+        [ -n "$IFACE" ] && break
+        sleep 0.2
+    done
+    [ -n "$IFACE" ] || die "driver did not bind to the emulated adapter"
+
+    ip link set "$IFACE" up
+    ip addr add "$LOCAL_IP/24" dev "$IFACE"
+    ip neigh replace "$PEER_IP" lladdr "$PEER_MAC" dev "$IFACE" nud permanent
+    sleep 1 # Let the RX filter registers settle
+}
+
+# pktgen flood with loopback off: TX path only
+bench_tx() {
+    local size=$1 p0 b0 c0 t0 f0 p1 b1 c1 t1 f1
+
+    emu_set loop 0
+    modprobe pktgen
+    pg kpktgend_0 "rem_device_all"
+    pg kpktgend_0 "add_device $IFACE"
+    pg "$IFACE" "count 0"
+    pg "$IFACE" "clone_skb 0"
+    pg "$IFACE" "pkt_size $((size - 4))" # pktgen adds the 4-byte FCS to pkt_size
+    pg "$IFACE" "delay 0"
+    pg "$IFACE" "dst $PEER_IP"
+    pg "$IFACE" "dst_mac $PEER_MAC"
+
+    p0=$(stat_of tx_packets); b0=$(stat_of tx_bytes); c0=$(cpu_busy); t0=$(tx_thread_ticks); f0="$(prof_snapshot)"
+    echo start > /proc/net/pktgen/pgctrl &
+    sleep "$BENCH_DURATION"
+    p1=$(stat_of tx_packets); b1=$(stat_of tx_bytes); c1=$(cpu_busy); t1=$(tx_thread_ticks); f1="$(prof_snapshot)"
+    echo stop > /proc/net/pktgen/pgctrl
+    wait || true
+    pg kpktgend_0 "rem_device_all"
+    emu_set loop 1
+
+    RESULTS+=("$(flood_json tx_flood "$size" tx $((p1 - p0)) $((b1 - b0)) $((c1 - c0)) $((t1 - t0)) "$f0" "$f1")")
+}
+
+# Emulator-generated RX flood: RX path only
+bench_rx() {
+    local size=$1 p0 b0 c0 f0 p1 b1 c1 f1
+
+    emu_set rx_flood_len $((size - 14))
+    p0=$(stat_of rx_packets); b0=$(stat_of rx_bytes); c0=$(cpu_busy); f0="$(prof_snapshot)"
+    emu_set rx_flood_pps "$BENCH_RX_PPS"
+    sleep "$BENCH_DURATION"
+    p1=$(stat_of rx_packets); b1=$(stat_of rx_bytes); c1=$(cpu_busy); f1="$(prof_snapshot)"
+    emu_set rx_flood_pps 0
+    sleep 0.5
+
+    RESULTS+=("$(flood_json rx_flood "$size" rx $((p1 - p0)) $((b1 - b0)) $((c1 - c0)) 0 "$f0" "$f1")")
+}
+
+# Round trip: driver TX -> emulator ICMP reflector -> driver RX
+bench_ping() {
+    local rtts
+
+    ping -n -q -c 10 -i 0.01 "$PEER_IP" > /dev/null 2>&1 || true # Warm up
+    rtts="$({ ping -n -c "$BENCH_PINGS" -i "$BENCH_PING_INTERVAL" "$PEER_IP" || true; } |
+            sed -n 's/.*time=\([0-9.]*\).*/\1/p')"
+    [ -n "$rtts" ] || die "no ping replies through the emulator"
+
+    RESULTS+=("$(echo "$rtts" | sort -n | awk -v sent="$BENCH_PINGS" '
+        { v[NR] = $1 * 1000 }
+        END {
+            p50 = v[int((NR - 1) * 0.50) + 1]; p99 = v[int((NR - 1) * 0.99) + 1]
+            printf "{\"test\": \"ping\", \"sent\": %d, \"received\": %d, \"p50_us\": %.1f, \"p99_us\": %.1f, \"max_us\": %.1f}",
+                   sent, NR, p50, p99, v[NR]
+        }')")
+}
+
+write_results() {
+    local i sep=""
+
+    {
+        printf '{\n  "date": "%s",\n' "$(date -u +%Y-%m-%dT%H:%M:%SZ)"
+        printf '  "kernel": "%s",\n' "$(uname -r)"
+        printf '  "commit": "%s",\n' "$(git -C "$SRC_DIR" rev-parse --short HEAD 2>/dev/null || echo unknown)"
+        printf '  "cpus": %d,\n' "$(nproc)"
+        printf '  "duration_s": %d,\n' "$BENCH_DURATION"
+        printf '  "results": [\n'
+        for i in "${RESULTS[@]}"; do
+            printf '%s    %s' "$sep" "$i"
+            sep=$',\n'
+        done
+        printf '\n  ]\n}\n'
+    } > "$BENCH_OUT"
+    echo "bench: results written to $BENCH_OUT"
+}
+
+setup
+for size in $BENCH_SIZES; do
+    echo "bench: TX flood, $size bytes"
+    bench_tx "$size"
+done
+for size in $BENCH_SIZES; do
+    echo "bench: RX flood, $size bytes"
+    bench_rx "$size"
+done
+echo "bench: ping-pong latency, $BENCH_PINGS samples"
+bench_ping
+write_results
@@ -0,0 +1,136 @@
+#!/bin/bash
+
+# Create and remove emulated RTL8811AU adapters through USB gadget configfs. Each
+# adapter is one gadget (rtl8811au_emu<N>) holding one rtl8811au function instance,
+# bound to the N-th UDC. Run as root with rtl8811au_emu.ko loaded, e.g.:
+#
+#   modprobe dummy_hcd num=4
+#   insmod rtl8811au_emu.ko
+#   ./rtl8811au-emu.sh create 4     # Gadgets 0..3, each bound to its UDC
+#   ./rtl8811au-emu.sh unbind 2     # Unplug adapter 2 ...
+#   ./rtl8811au-emu.sh bind 2       # ... and plug it back in
+#   ./rtl8811au-emu.sh list
+#   ./rtl8811au-emu.sh destroy      # Unbind and remove every gadget
+#
+# Adapter N's counters are in /sys/kernel/debug/rtl8811au_emu/<N>/stats.
+
+set -euo pipefail
+
+CONFIGFS="/sys/kernel/config"
+GADGETS="$CONFIGFS/usb_gadget"
+PREFIX="rtl8811au_emu"
+
+die() {
+    echo "rtl8811au-emu: $*" >&2
+    exit 1
+}
+
+# Name of the N-th UDC, in the order dummy_hcd numbers them
+udc_of() {
+    local udc
+    udc="$(ls /sys/class/udc 2>/dev/null | sort -V | sed -n "$(($1 + 1))p")"
+    [ -n "$udc" ] || die "no UDC for adapter $1 (modprobe dummy_hcd num=<adapters>)"
+    echo "$udc"
+}
+
+create_one() {
+    local n=$1 g="$GADGETS/$PREFIX$1"
+
+    [ -d "$g" ] && die "adapter $n already exists"
+    mkdir "$g"
+    echo 0x2357 > "$g/idVendor"   # TP-Link
+    echo 0x011e > "$g/idProduct"  # Archer T2U Nano (AC600)
+    echo 0x0200 > "$g/bcdDevice"
+    mkdir "$g/strings/0x409"
+    echo "Realtek" > "$g/strings/0x409/manufacturer"
+    echo "802.11ac NIC (emulated)" > "$g/strings/0x409/product"
+    printf '00e04c%06x\n' $((n + 1)) > "$g/strings/0x409/serialnumber"
+
+    mkdir "$g/configs/c.1"
+    echo 0xe0 > "$g/configs/c.1/bmAttributes" # Self-powered, remote wakeup
+    echo 500 > "$g/configs/c.1/MaxPower"
+
+    mkdir "$g/functions/rtl8811au.$n"
+    ln -s "$g/functions/rtl8811au.$n" "$g/configs/c.1/"
+}
+
+bind_one() {
+    echo "$(udc_of "$1")" > "$GADGETS/$PREFIX$1/UDC"
+}
+
+unbind_one() {
+    local udc="$GADGETS/$PREFIX$1/UDC"
+
+    # Writing an empty name to an unbound gadget fails
+    if [ -n "$(cat "$udc")" ]; then
+        echo "" > "$udc"
+    fi
+}
+
+destroy_one() {
+    local g=$1 f
+
+    if [ -n "$(cat "$g/UDC")" ]; then
+        echo "" > "$g/UDC"
+    fi
+    for f in "$g"/configs/c.1/rtl8811au.*; do
+        if [ -L "$f" ]; then
+            rm "$f"
+        fi
+    done
+    rmdir "$g/configs/c.1"
+    for f in "$g"/functions/rtl8811au.*; do
+        if [ -d "$f" ]; then
+            rmdir "$f"
+        fi
+    done
+    rmdir "$g/strings/0x409"
+    rmdir "$g"
+}
+
+setup_configfs() {
+    [ "$(id -u)" = 0 ] || die "must run as root"
+    if [ ! -d "$GADGETS" ]; then
+        modprobe libcomposite || die "gadget configfs not available (CONFIG_USB_CONFIGFS)"
+        mountpoint -q "$CONFIGFS" || mount -t configfs none "$CONFIGFS"
+    fi
+    [ -d "$GADGETS" ] || die "$GADGETS missing"
+    [ -d /sys/module/rtl8811au_emu ] || die "load rtl8811au_emu.ko first"
+}
+
+cmd="${1:-}"
+case "$cmd" in
+create)
+    setup_configfs
+    count="${2:-1}"
+    for n in $(seq 0 $((count - 1))); do
+        create_one "$n"
+        bind_one "$n"
+    done
+    ;;
+bind)
+    [ -n "${2:-}" ] || die "usage: $0 bind <adapter>"
+    bind_one "$2"
+    ;;
+unbind)
+    [ -n "${2:-}" ] || die "usage: $0 unbind <adapter>"
+    unbind_one "$2"
+    ;;
+list)
+    for g in "$GADGETS/$PREFIX"*; do
+        [ -d "$g" ] || continue
+        echo "${g##*/$PREFIX} ${g##*/} udc=$(cat "$g/UDC")"
+    done
+    ;;
+destroy)
+    for g in "$GADGETS/$PREFIX"*; do
+        if [ -d "$g" ]; then
+            destroy_one "$g"
+        fi
+    done
+    ;;
+*)
+    echo "usage: $0 create [count] | bind <n> | unbind <n> | list | destroy" >&2
+    exit 1
+    ;;
+esac
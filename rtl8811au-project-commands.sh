@@ -85,6 +85,15 @@ echo "cd $SOURCE_DIR"
 echo "make clean"
 echo "make"
 
+echo -e "\n# Benchmark against the emulated adapter (on a host with dummy_hcd; results in bench-results.json)"
+echo "cd $SOURCE_DIR && make bench"
+
+echo -e "\n# Hotplug stress test: 4 emulated adapters unplugged and replugged together under traffic"
+echo "cd $SOURCE_DIR && make stress STRESS_ADAPTERS=4 STRESS_ROUNDS=20"
+
+echo -e "\n# KUnit suite for the TX/RX handlers, run by kunit.py in QEMU (needs a scratch kernel source tree)"
+echo "cd $SOURCE_DIR && make kunit KUNIT_KDIR=\$HOME/linux"
+
 # --- Miscellaneous ---
 echo -e "\n# Check USB devices (on host or VM)"
 echo "lsusb"
@@ -0,0 +1,194 @@
+#!/bin/bash
+
+# Hotplug stress test for the rtl8811au driver. STRESS_ADAPTERS emulated adapters
+# (rtl8811au_emu.ko, one configfs gadget each on dummy_hcd) are unplugged and plugged
+# back in at the same time while traffic runs through all of them. Run as root,
+# normally through `make stress`.
+#
+# Each round brings every interface up and starts an emulator RX flood plus a ping
+# through each adapter. It then unbinds and rebinds all gadgets concurrently, each
+# after a random delay, and waits for every adapter to come back. The test fails on:
+#   - an adapter that does not come back
+#   - a kernel warning, BUG, oops or hung task logged during the run
+#   - netdevs or TX threads left behind once every adapter is unplugged
+#   - a module that cannot be unloaded at the end
+
+set -euo pipefail
+
+# Variables (override from the environment)
+SRC_DIR="$(cd "$(dirname "$0")" && pwd)"
+STRESS_ADAPTERS="${STRESS_ADAPTERS:-4}"
+STRESS_ROUNDS="${STRESS_ROUNDS:-20}"
+STRESS_TRAFFIC_S="${STRESS_TRAFFIC_S:-1}"       # Traffic before each unplug, seconds
+STRESS_RX_PPS="${STRESS_RX_PPS:-20000}"         # Emulator RX flood, per adapter
+
+DRIVER="rtl8811au_wifi"                         # usb_driver name in rtl8811au.c
+FIRMWARE="/lib/firmware/rtl8811au/rtl8811au_fw.bin"
+EMU="$SRC_DIR/rtl8811au-emu.sh"
+EMU_PARAMS="/sys/module/rtl8811au_emu/parameters"
+PEER_MAC="02:88:11:a0:00:02"
+MARKER="rtl8811au-stress: start $$"
+KERNEL_ISSUES='WARNING:|BUG:|Oops|general protection|KASAN|UBSAN|refcount_t|list_(add|del) corruption|blocked for more than'
+
+LOADED_DUMMY_HCD=0
+CREATED_FIRMWARE=0
+PINGS=()
+
+die() {
+    echo "stress: $*" >&2
+    exit 1
+}
+
+stop_traffic() {
+    local p
+
+    for p in ${PINGS[@]+"${PINGS[@]}"}; do
+        kill "$p" 2>/dev/null || true
+        wait "$p" 2>/dev/null || true
+    done
+    PINGS=()
+}
+
+cleanup() {
+    set +e
+    stop_traffic
+    [ -w "$EMU_PARAMS/rx_flood_pps" ] && echo 0 > "$EMU_PARAMS/rx_flood_pps"
+    [ -d /sys/module/rtl8811au_emu ] && "$EMU" destroy 2>/dev/null
+    rmmod rtl8811au 2>/dev/null
+    rmmod rtl8811au_emu 2>/dev/null
+    [ "$LOADED_DUMMY_HCD" = 1 ] && rmmod dummy_hcd 2>/dev/null
+    [ "$CREATED_FIRMWARE" = 1 ] && rm -f "$FIRMWARE"
+}
+
+# Interfaces currently bound to the driver
+ifaces() {
+    local dev
+
+    for dev in /sys/bus/usb/drivers/$DRIVER/*/net/*; do
+        [ -e "$dev" ] || continue # Unmatched glob
+        echo "${dev##*/}"
+    done
+}
+
+# Wait up to 10 s for exactly $1 interfaces
+wait_ifaces() {
+    for _ in $(seq 100); do
+        if [ "$(ifaces | wc -l)" -eq "$1" ]; then
+            return 0
+        fi
+        sleep 0.1
+    done
+    return 1
+}
+
+# Fail on anything the kernel logged since the marker
+check_kernel_log() {
+    local issues
+
+    issues="$(dmesg | sed -n "/$MARKER/,\$p" | grep -E "$KERNEL_ISSUES" || true)"
+    if [ -n "$issues" ]; then
+        echo "$issues" >&2
+        die "kernel reported problems $1"
+    fi
+}
+
+setup() {
+    [ "$(id -u)" = 0 ] || die "must run as root"
+    [ -f "$SRC_DIR/rtl8811au.ko" ] && [ -f "$SRC_DIR/rtl8811au_emu.ko" ] ||
+        die "build first (the emulator needs a kernel with CONFIG_USB_LIBCOMPOSITE)"
+    [ "$STRESS_ADAPTERS" -ge 1 ] || die "STRESS_ADAPTERS must be at least 1"
+
+    trap cleanup EXIT
+
+    if ! lsmod | grep -q '^dummy_hcd'; then
+        modprobe dummy_hcd num="$STRESS_ADAPTERS" || die "dummy_hcd not available"
+        LOADED_DUMMY_HCD=1
+    fi
+    [ "$(ls /sys/class/udc | wc -l)" -ge "$STRESS_ADAPTERS" ] ||
+        die "need $STRESS_ADAPTERS UDCs (rmmod dummy_hcd and rerun, or load it with num=$STRESS_ADAPTERS)"
+    # The driver requests firmware in probe but does not upload it yet; any file will do
+    if [ ! -e "$FIRMWARE" ]; then
+        mkdir -p "$(dirname "$FIRMWARE")"
+        head -c 16 /dev/zero > "$FIRMWARE"
+        CREATED_FIRMWARE=1
+    fi
+
+    echo "$MARKER" > /dev/kmsg
+    insmod "$SRC_DIR/rtl8811au_emu.ko"
+    insmod "$SRC_DIR/rtl8811au.ko"
+    "$EMU" create "$STRESS_ADAPTERS"
+    wait_ifaces "$STRESS_ADAPTERS" || die "driver did not bind to all $STRESS_ADAPTERS adapters"
+}
+
+# Bring every interface up and ping a peer behind each; the emulator reflects the
+# requests, and its RX flood keeps the RX path busy at the same time
+start_traffic() {
+    local i=0 ifc
+
+    echo "$STRESS_RX_PPS" > "$EMU_PARAMS/rx_flood_pps"
+    for ifc in $(ifaces); do
+        ip link set "$ifc" up
+        ip addr replace "10.89.$i.1/24" dev "$ifc"
+        ip neigh replace "10.89.$i.2" lladdr "$PEER_MAC" dev "$ifc" nud permanent
+        ping -n -q -i 0.002 -I "$ifc" "10.89.$i.2" > /dev/null 2>&1 &
+        PINGS+=($!)
+        i=$((i + 1))
+    done
+}
+
+# Unplug every adapter and plug it back in, all at once, with traffic still running
+hotplug_round() {
+    local n p pids=()
+
+    for n in $(seq 0 $((STRESS_ADAPTERS - 1))); do
+        (
+            sleep "0.$((RANDOM % 10))"
+            "$EMU" unbind "$n"
+            sleep "0.$((RANDOM % 10))"
+            "$EMU" bind "$n"
+        ) &
+        pids+=($!)
+    done
+    for p in "${pids[@]}"; do
+        wait "$p" || die "round $1: rebinding the gadgets failed"
+    done
+}
+
+# Unplug everything concurrently, then check nothing is left and the modules unload
+teardown() {
+    local n p pids=()
+
+    stop_traffic
+    echo 0 > "$EMU_PARAMS/rx_flood_pps"
+    for n in $(seq 0 $((STRESS_ADAPTERS - 1))); do
+        "$EMU" unbind "$n" &
+        pids+=($!)
+    done
+    for p in "${pids[@]}"; do
+        wait "$p" || die "unbinding the gadgets failed"
+    done
+
+    wait_ifaces 0 || die "netdevs left after unplugging every adapter: $(ifaces | tr '\n' ' ')"
+    if pgrep '^r8811tx/' > /dev/null; then
+        die "TX threads left after unplugging every adapter"
+    fi
+
+    "$EMU" destroy
+    rmmod rtl8811au || die "rtl8811au could not be unloaded"
+    rmmod rtl8811au_emu || die "rtl8811au_emu could not be unloaded"
+    check_kernel_log "during teardown"
+}
+
+setup
+for round in $(seq 1 "$STRESS_ROUNDS"); do
+    echo "stress: round $round/$STRESS_ROUNDS, $STRESS_ADAPTERS adapters"
+    start_traffic
+    sleep "$STRESS_TRAFFIC_S"
+    hotplug_round "$round"
+    stop_traffic
+    wait_ifaces "$STRESS_ADAPTERS" ||
+        die "round $round: only $(ifaces | wc -l) of $STRESS_ADAPTERS adapters came back"
+    check_kernel_log "in round $round"
+done
+teardown
+echo "stress: passed, $STRESS_ROUNDS rounds with $STRESS_ADAPTERS adapters"
@@ -12,35 +12,448 @@
 // #include <linux/completion.h> // Removed, tx_complete was unused
 #include <linux/delay.h> // Keep for mdelay/udelay if needed later, but avoid msleep in atomic
 #include <linux/workqueue.h>
+#include <linux/bitfield.h>
+#include <linux/build_bug.h>
+#include <linux/ethtool.h>
+#include <linux/rcupdate.h>
+#include <linux/rtnetlink.h>
+#include <linux/bpf.h>
+#include <linux/bpf_trace.h>
+#include <linux/filter.h>
+#include <net/xdp.h>
+#include <net/ieee80211_radiotap.h>
+#include <linux/if_arp.h>
+#include <linux/crc32.h>
+#include <linux/mutex.h>
+#include <linux/pm_runtime.h>
+#include <linux/kthread.h>
+#include <linux/cpumask.h>
+#include <linux/sched.h>
+#include <linux/hrtimer.h>
+#include <linux/percpu.h>
+#include <linux/u64_stats_sync.h>
 
 // Device Vendor and Product IDs
 #define USB_VENDOR_ID_TP_LINK 0x2357
 #define USB_PRODUCT_ID_AC600_NANO 0x011e
 #define RTL8811AU_FIRMWARE "rtl8811au/rtl8811au_fw.bin"
 
-// Maximum packet size
-#define MAX_PACKET_SIZE 2048
-#define MAX_RX_ERRORS 5 // Example: Allow up to 5 consecutive errors before stopping RX resubmits
+// Largest MTU. The chip takes VHT MPDUs up to 11454 bytes, which leaves room for
+// 9000-byte jumbo frames plus 802.11, LLC/SNAP and security overhead.
+#define RTL8811AU_MAX_MTU 9000
+#define MAX_RX_ERRORS 5 // Consecutive errors before a URB is handed to the recovery engine
+
+// RX recovery: parked URBs are resubmitted from process context with exponential backoff;
+// after RTL8811AU_RX_RECOVERY_MAX_ATTEMPTS failed rounds the device is reset.
+#define RTL8811AU_RX_RECOVERY_BASE_MS 10
+#define RTL8811AU_RX_RECOVERY_MAX_MS 2000
+#define RTL8811AU_RX_RECOVERY_MAX_ATTEMPTS 8
+
+// TX coalescing (ethtool -C tx-usecs/tx-frames): frames are held for up to tx-usecs,
+// or until tx-frames frames or a full aggregation buffer are queued, then sent as one
+// bulk-out transfer. Each frame in the aggregate starts on an 8-byte boundary.
+#define RTL8811AU_TX_AGG_BUF_SIZE 32768 // Allocation; the limit in use is priv->tx_agg_size
+#define RTL8811AU_TX_AGG_ALIGN 8
+#define RTL8811AU_TX_AGG_MAX_FRAMES 32
+#define RTL8811AU_TX_COAL_MAX_USECS 10000
+
+// TX stall watchdog: a TX URB outstanding for longer than this is unlinked. After
+// RTL8811AU_TX_MAX_STALLS stalls in a row without a good completion the device is reset.
+#define RTL8811AU_TX_TIMEOUT (5 * HZ)
+#define RTL8811AU_TX_MAX_STALLS 3
+
+// TX backpressure: the netdev queue stops once more than RTL8811AU_TX_QUEUE_STOP frames
+// are waiting for the worker, and the worker wakes it below RTL8811AU_TX_QUEUE_WAKE
+#define RTL8811AU_TX_QUEUE_STOP 100
+#define RTL8811AU_TX_QUEUE_WAKE 50
+
+// Runtime PM: the autosuspend delay adapts between these bounds (see rtl8811au_resume)
+#define RTL8811AU_AUTOSUSPEND_MIN_MS 200
+#define RTL8811AU_AUTOSUSPEND_DEFAULT_MS 1000
+#define RTL8811AU_AUTOSUSPEND_MAX_MS 10000
+
+static bool autosuspend = true;
+module_param(autosuspend, bool, 0444);
+MODULE_PARM_DESC(autosuspend, "Enable USB autosuspend when idle (default: true)");
+
+// TX thread priority: nice RTL8811AU_TX_NICE by default, SCHED_FIFO with tx_rt=1
+#define RTL8811AU_TX_NICE (-10)
+
+static bool tx_rt;
+module_param(tx_rt, bool, 0444);
+MODULE_PARM_DESC(tx_rt, "Run the TX thread as SCHED_FIFO (default: false)");
+
+// Handler timing: the datapath handlers add their run time to the prof_* counters in
+// ethtool -S. Off by default, as it costs two clock reads per call.
+static bool handler_timing;
+module_param(handler_timing, bool, 0644);
+MODULE_PARM_DESC(handler_timing, "Account time spent in the TX/RX handlers (default: false)");
+
+// RX URB pool: several large bulk-in buffers stay in flight so the device can keep
+// aggregating frames while earlier buffers are parsed
+#define RTL8811AU_NUM_RX_URBS 8
+
+// Buffer sizing (see rtl8811au_size_buffers): room for this many MTU-sized frames per
+// bulk transfer, up to a per-bus cap. Faster buses get deeper aggregation; small MTUs
+// get smaller buffers.
+#define RTL8811AU_FRAME_OVERHEAD 128 // RX desc + PHY status + 802.11/QoS/HT + LLC + IV + FCS
+#define RTL8811AU_AGG_FRAMES_SS 32
+#define RTL8811AU_AGG_FRAMES_HS 8
+#define RTL8811AU_AGG_FRAMES_FS 1
+#define RTL8811AU_AGG_CAP_SS 65536
+#define RTL8811AU_AGG_CAP_HS 32768
+#define RTL8811AU_AGG_CAP_FS 4096
+
+// --- Register Interface ---
+// MAC registers are accessed with vendor control requests on endpoint 0
+#define RTL8811AU_USB_REQ_VENDOR 0x05
+#define RTL8811AU_USB_REQ_READ   (USB_DIR_IN | USB_TYPE_VENDOR | USB_RECIP_DEVICE)
+#define RTL8811AU_USB_REQ_WRITE  (USB_DIR_OUT | USB_TYPE_VENDOR | USB_RECIP_DEVICE)
+#define RTL8811AU_USB_CTRL_TIMEOUT 500 // ms
+
+#define REG_RCR                 0x0608  // RX configuration
+#define REG_MACID               0x0610  // Own MAC address (6 bytes)
+#define REG_BSSID               0x0618  // Associated BSSID (6 bytes)
+#define REG_MAR                 0x0620  // Multicast hash filter (8 bytes)
+
+#define RCR_AAP                 BIT(0)  // Accept all unicast (promiscuous)
+#define RCR_APM                 BIT(1)  // Accept unicast to our address
+#define RCR_AM                  BIT(2)  // Accept multicast matching MAR
+#define RCR_AB                  BIT(3)  // Accept broadcast
+#define RCR_CBSSID_DATA         BIT(6)  // Drop data frames from other BSSIDs
+#define RCR_CBSSID_BCN          BIT(7)  // Drop beacons from other BSSIDs
+#define RCR_ACRC32              BIT(8)  // Deliver frames with CRC errors
+#define RCR_AICV                BIT(9)  // Deliver frames with ICV errors
+#define RCR_ADF                 BIT(11) // Accept data frames
+#define RCR_ACF                 BIT(12) // Accept control frames
+#define RCR_AMF                 BIT(13) // Accept management frames
+#define RCR_HTC_LOC_CTRL        BIT(14)
+#define RCR_APP_PHYSTS          BIT(28) // Append PHY status to every frame
+
+#define RTL8811AU_RCR_STATION   (RCR_APM | RCR_AM | RCR_AB | RCR_CBSSID_DATA | RCR_CBSSID_BCN | \
+                                 RCR_ADF | RCR_AMF | RCR_HTC_LOC_CTRL | RCR_APP_PHYSTS)
+#define RTL8811AU_RCR_MONITOR   (RCR_AAP | RCR_APM | RCR_AM | RCR_AB | RCR_ACRC32 | RCR_AICV | \
+                                 RCR_ADF | RCR_ACF | RCR_AMF | RCR_HTC_LOC_CTRL | RCR_APP_PHYSTS)
+
+// Host copy of the registers the driver programs. ndo_set_rx_mode runs in atomic context,
+// so it only updates this copy; a work item pushes the differences to the chip.
+struct rtl8811au_reg_shadow {
+    u32 rcr;
+    u8 mar[8];
+    u8 macid[ETH_ALEN];
+    u8 bssid[ETH_ALEN];
+};
+
+// --- RX Descriptor Layout ---
+// Every frame in the bulk-in buffer starts with a 24-byte RX descriptor, followed by
+// drvinfo_sz * 8 bytes of driver info (the PHY status report when PHYST is set),
+// `shift` bytes of padding and then the 802.11 frame. With USB RX aggregation several
+// such frames are packed back to back, each starting on an 8-byte boundary.
+#define RTL8811AU_RX_DESC_SIZE 24
+#define RTL8811AU_RX_DRVINFO_UNIT 8
+#define RTL8811AU_RX_AGG_ALIGN 8
+
+struct rtl8811au_rx_desc {
+    __le32 dw0;
+    __le32 dw1;
+    __le32 dw2;
+    __le32 dw3;
+    __le32 dw4;
+    __le32 dw5;
+} __packed;
+static_assert(sizeof(struct rtl8811au_rx_desc) == RTL8811AU_RX_DESC_SIZE);
+
+#define RX_DESC_DW0_PKT_LEN     GENMASK(13, 0)
+#define RX_DESC_DW0_CRC32       BIT(14)
+#define RX_DESC_DW0_ICV_ERR     BIT(15)
+#define RX_DESC_DW0_DRVINFO_SZ  GENMASK(19, 16)
+#define RX_DESC_DW0_SECURITY    GENMASK(22, 20)
+#define RX_DESC_DW0_QOS         BIT(23)
+#define RX_DESC_DW0_SHIFT       GENMASK(25, 24)
+#define RX_DESC_DW0_PHYST       BIT(26)
+#define RX_DESC_DW0_SWDEC       BIT(27)
+#define RX_DESC_DW1_MACID       GENMASK(6, 0)
+#define RX_DESC_DW1_TID         GENMASK(11, 8)
+#define RX_DESC_DW2_SEQ         GENMASK(11, 0)
+#define RX_DESC_DW2_FRAG        GENMASK(15, 12)
+#define RX_DESC_DW2_RPT_SEL     BIT(28) // Firmware C2H report, not a received frame
+#define RX_DESC_DW3_RX_RATE     GENMASK(6, 0)
+#define RX_DESC_DW5_TSFL        GENMASK(31, 0)
+
+// Cipher reported in RX_DESC_DW0_SECURITY; hardware leaves IV and ICV/MIC in the frame
+#define RTL8811AU_SEC_NONE      0
+#define RTL8811AU_SEC_WEP40     1
+#define RTL8811AU_SEC_TKIP      2
+#define RTL8811AU_SEC_AES       4
+#define RTL8811AU_SEC_WEP104    5
+
+// PHY status report (Jaguar-series layout) carried in the driver info area
+struct rtl8811au_rx_phy_status {
+    u8 gain_trsw[2];
+    __le16 chl_info;        // chl_num:10, sub_chnl:4, r_rfmod:2
+    u8 pwdb_all;            // Overall received power, 0.5 dB steps offset by 110
+    u8 cfosho[4];
+    u8 cfotail[4];
+    s8 rxevm[2];
+    s8 rxsnr[2];
+    u8 pcts_msk_rpt[2];
+    u8 pdsnr[2];
+    u8 csi_current[2];
+    u8 rx_gain_c;
+    u8 rx_gain_d;
+    u8 sigevm;
+    u8 resvd_0;
+    u8 antidx_anta_b;
+    u8 antidx_c_d;
+    u8 rsvd[3];
+} __packed;
+static_assert(sizeof(struct rtl8811au_rx_phy_status) == 32);
+
+#define RX_PHY_CHL_NUM          GENMASK(9, 0)
+
+// Hardware rate indices reported in RX_DESC_DW3_RX_RATE
+#define RTL8811AU_DESC_RATE_CCK_MAX   3   // 1, 2, 5.5, 11 Mbps
+#define RTL8811AU_DESC_RATE_OFDM_MAX  11  // 6 .. 54 Mbps
+#define RTL8811AU_DESC_RATE_HT_MAX    43  // HT MCS0 .. MCS31
+#define RTL8811AU_DESC_RATE_VHT_MAX   83  // VHT 1SS MCS0 .. 4SS MCS9
+
+// Decoded once per frame by rtl8811au_parse_rx_desc()
+struct rtl8811au_rx_info {
+    unsigned int frame_offset;  // Offset of the 802.11 frame from the descriptor start
+    unsigned int total_len;     // Bytes consumed in the bulk-in buffer (incl. alignment)
+    u16 pkt_len;                // 802.11 frame length including FCS
+    u8 rate;                    // Hardware rate index
+    u8 security;                // RTL8811AU_SEC_* cipher
+    u8 pwdb;                    // Raw PHY power report, valid if has_phy_status
+    s8 rssi;                    // dBm, valid if has_phy_status
+    u8 channel;                 // Channel number, valid if has_phy_status
+    u32 tsfl;                   // Low 32 bits of the TSF at reception
+    bool crc_err;
+    bool icv_err;
+    bool has_phy_status;
+    bool is_c2h;
+};
+
+// Per-transfer counters, applied to the shared statistics once per bulk-in buffer
+struct rtl8811au_rx_batch {
+    unsigned int frames, crc_err, icv_err, desc_err, c2h, non_data, decap_err;
+    unsigned int packets, bytes, dropped;
+    unsigned int xdp_drop, xdp_tx, xdp_redirect, xdp_aborted;
+    unsigned int monitor;
+    bool have_phy;
+    u8 last_rate, last_pwdb;
+};
+
+// Decapsulated frames are copied into page fragments with XDP headroom in front, so the
+// XDP program runs before any skb exists and XDP_PASS builds the skb around the same memory.
+#define RTL8811AU_RX_HEADROOM (XDP_PACKET_HEADROOM + NET_IP_ALIGN)
+#define RTL8811AU_RX_TRUESIZE(len) (SKB_DATA_ALIGN(RTL8811AU_RX_HEADROOM + (len)) + \
+                                    SKB_DATA_ALIGN(sizeof(struct skb_shared_info)))
+// Largest MTU whose frames still fit in the single page XDP requires
+#define RTL8811AU_XDP_MAX_MTU (PAGE_SIZE - RTL8811AU_RX_HEADROOM - ETH_HLEN - \
+                               SKB_DATA_ALIGN(sizeof(struct skb_shared_info)))
+
+// --- Radiotap ---
+// Monitor-mode frames get a radiotap header written into the RX headroom in front of the
+// copied 802.11 frame. Fields follow in present-bit order, each at its natural alignment
+// from the start of the header: TSFT, FLAGS, then RATE, CHANNEL and DBM_ANTSIGNAL when
+// known, then MCS (HT) or VHT. The longest is header + TSFT + FLAGS + CHANNEL (after one
+// pad byte) + ANTSIGNAL + VHT (after one pad byte).
+#define RTL8811AU_RADIOTAP_MAX_LEN (sizeof(struct ieee80211_radiotap_header) + 8 + 1 + 1 + 4 + 1 + 1 + 12)
+static_assert(RTL8811AU_RADIOTAP_MAX_LEN <= RTL8811AU_RX_HEADROOM);
+
+// --- TX Descriptor Layout ---
+// Bulk-out transfers carry a 40-byte TX descriptor in front of each 802.11 frame.
+#define RTL8811AU_TX_DESC_SIZE 40
+
+struct rtl8811au_tx_desc {
+    __le32 dw0;
+    __le32 dw1;
+    __le32 dw2;
+    __le32 dw3;
+    __le32 dw4;
+    __le32 dw5;
+    __le32 dw6;
+    __le32 dw7;
+    __le32 dw8;
+    __le32 dw9;
+} __packed;
+static_assert(sizeof(struct rtl8811au_tx_desc) == RTL8811AU_TX_DESC_SIZE);
+
+#define TX_DESC_DW0_PKT_SIZE    GENMASK(15, 0)
+#define TX_DESC_DW0_OFFSET      GENMASK(23, 16)
+#define TX_DESC_DW0_BMC         BIT(24)
+#define TX_DESC_DW0_LS          BIT(26)
+#define TX_DESC_DW0_FS          BIT(27)
+#define TX_DESC_DW0_OWN         BIT(31)
+#define TX_DESC_DW1_MACID       GENMASK(6, 0)
+#define TX_DESC_DW1_QSEL        GENMASK(12, 8)
+#define TX_DESC_DW1_RATE_ID     GENMASK(20, 16)
+#define TX_DESC_DW7_CHECKSUM    GENMASK(15, 0)
+#define TX_DESC_DW7_USB_AGG_NUM GENMASK(31, 24) // Frames in the transfer, first descriptor only
+#define TX_DESC_DW9_SEQ         GENMASK(23, 12)
+
+#define RTL8811AU_RATEID_BGN_20M 0 // Firmware rate-adaptation table for 2.4 GHz b/g/n
+
+// Everything pushed in front of the Ethernet payload on TX. Built at open (and when our
+// address changes) and copied into skb headroom for every frame; only the length, queue, sequence number,
+// destination, EtherType and descriptor checksum are patched per packet.
+struct rtl8811au_tx_hdr {
+    struct rtl8811au_tx_desc desc;
+    struct ieee80211_hdr_3addr hdr;
+    u8 llc_snap[6];             // RFC 1042 encapsulation
+    __be16 ethertype;
+} __packed;
+static_assert(sizeof(struct rtl8811au_tx_hdr) == RTL8811AU_TX_DESC_SIZE + 24 + 8);
+
+// TX header template, replaced under RCU. The driver has no connect op yet, so the BSSID
+// is always the zero placeholder in priv->bssid; a future association path would rebuild
+// the template with the AP's address.
+struct rtl8811au_hdr_cache {
+    struct rcu_head rcu;
+    u8 bssid[ETH_ALEN];
+    struct rtl8811au_tx_hdr tmpl;
+};
+
+// Driver-private counters exported through ethtool -S
+struct rtl8811au_ext_stats {
+    u64 rx_frames;          // Frames decoded from bulk-in buffers
+    u64 rx_crc_err;         // Dropped before skb allocation: CRC32 failure
+    u64 rx_icv_err;         // Dropped before skb allocation: ICV failure
+    u64 rx_desc_err;        // Truncated or malformed RX descriptors
+    u64 rx_c2h;             // Firmware reports skipped in the data path
+    u64 rx_non_data;        // Management/control frames not handled by the data path
+    u64 rx_decap_err;       // Data frames too short to carry an LLC/SNAP header
+    u64 tx_encap_err;       // Frames dropped while building the 802.11 header
+    u64 tx_headroom_realloc; // Frames that needed skb_cow_head() to grow headroom
+    u64 rx_xdp_drop;        // XDP verdicts on the RX path
+    u64 rx_xdp_tx;
+    u64 rx_xdp_redirect;
+    u64 rx_xdp_aborted;     // XDP_ABORTED, invalid actions and failed TX/redirects
+    u64 tx_xdp_xmit;        // Frames accepted through ndo_xdp_xmit
+    u64 tx_xdp_xmit_err;    // Frames refused by ndo_xdp_xmit
+    u64 rx_monitor;         // Frames delivered to a monitor interface
+    u64 rx_drop_nomem;      // Frames dropped for lack of an RX buffer/skb
+    u64 rx_drop_urb_err;    // Bulk-in transfers lost to USB errors
+    u64 tx_drop_monitor;    // Frames sent to a monitor interface (no injection)
+    u64 hw_filter_writes;   // Filter register updates pushed to the chip
+    u64 hw_filter_err;      // Failed filter register writes
+    u64 rx_recovery_rounds; // Runs of the RX recovery work
+    u64 rx_recoveries;      // Outages that ended with RX flowing again
+    u64 rx_halt_clears;     // usb_clear_halt() on the bulk-in endpoint after -EPIPE
+    u64 rx_resets;          // Escalations to a USB device reset
+    u64 rx_recovery_last_us; // Time from first failure to the next good transfer
+    u64 rx_recovery_max_us;
+    u64 tx_agg_urbs;        // Coalesced bulk-out transfers
+    u64 tx_agg_frames;      // Frames sent inside them
+    u64 tx_coal_timeouts;   // Coalescing windows closed by the tx-usecs timer
+    u64 tx_stalls;          // TX URBs unlinked by the watchdog
+    u64 tx_timeouts;        // ndo_tx_timeout calls from the stack's watchdog
+    u64 tx_stall_resets;    // Escalations to a USB device reset
+    u64 tx_stall_recovery_last_us; // Time from the stall to the next good completion
+    u64 tx_stall_recovery_max_us;
+    u64 rx_buf_size;        // Current bulk-in buffer size
+    u64 rx_resizes;         // RX pool rebuilds for an MTU change
+    u64 pm_suspends;
+    u64 pm_resumes;
+    u64 pm_premature_wakes; // Resumed before a full autosuspend delay had passed
+    u64 pm_autosuspend_ms;  // Current adaptive autosuspend delay
+    u64 pm_resume_last_us;  // Time spent in the resume callback
+    u64 pm_resume_max_us;
+    u64 pm_wake_last_us;    // TX-triggered wake: queued frame to device ready
+    u64 pm_wake_max_us;
+    u64 rx_last_rate;       // Hardware rate index of the last good frame
+    u64 rx_last_pwdb;       // Raw PHY power of the last good frame
+};
+
+// Handler timing (handler_timing), kept per CPU: the handlers add to their own CPU's
+// copy without taking stats_lock, and ethtool -S sums the copies. For each handler,
+// time spent and the units it handled (frames or URBs).
+enum rtl8811au_prof_handler {
+    RTL8811AU_PROF_XMIT,        // rtl8811au_xmit, per frame accepted
+    RTL8811AU_PROF_TX_WORKER,   // TX worker, per frame submitted
+    RTL8811AU_PROF_TX_COMPLETE, // TX completion, per URB
+    RTL8811AU_PROF_RX_COMPLETE, // RX completion, per URB
+    RTL8811AU_PROF_RX_POLL,     // NAPI poll (parse, XDP, skb build), per frame
+    RTL8811AU_PROF_NUM,
+};
+
+struct rtl8811au_prof_stats {
+    u64_stats_t ns[RTL8811AU_PROF_NUM];
+    u64_stats_t count[RTL8811AU_PROF_NUM];
+    struct u64_stats_sync syncp;
+};
 
 // Driver structure
+// Per-device context. Lives in the netdev private area (alloc_etherdev) and is the only
+// copy: netdev_priv(), usb_get_intfdata() and rtl8811au_wiphy_priv() all return it.
 struct rtl8811au_dev {
     struct usb_device *usb_dev;
     struct usb_interface *usb_intf;
     const struct firmware *firmware;
     struct wiphy *wiphy;
     struct net_device *net_dev;
+    struct wireless_dev wdev;               // net_dev->ieee80211_ptr
+    struct workqueue_struct *wq;            // Filters, RX recovery and PM work for this device
 
     // USB URB management
-    struct urb *rx_urb;
+    struct urb *rx_urbs[RTL8811AU_NUM_RX_URBS]; // Bulk-in URBs, each with a coherent buffer
+    struct usb_anchor rx_anchor;            // RX URBs currently submitted
+    unsigned int rx_buf_size;               // Size of each bulk-in buffer, set at open/MTU change
+    unsigned int tx_max_len;                // Largest TX frame (descriptor included) for the MTU
+    unsigned int tx_agg_size;               // Coalesced transfer limit, <= RTL8811AU_TX_AGG_BUF_SIZE
+    u16 bulk_in_maxp, bulk_out_maxp;        // Endpoint wMaxPacketSize
     int rx_error_count; // Track RX errors
-    unsigned char *rx_buffer;
-    dma_addr_t rx_dma;
-    struct workqueue_struct *tx_wq;         // TX Workqueue
+    struct napi_struct napi;                // Bulk-in buffers are parsed in NAPI poll
+    struct list_head rx_done;               // Completed RX URBs waiting for poll (via urb_list)
+    spinlock_t rx_done_lock;                // Lock for rx_done and the RX recovery state
+    struct list_head rx_refill;             // URBs waiting for the recovery work (via urb_list)
+    struct delayed_work rx_recovery_work;
+    unsigned int rx_recovery_attempts;      // Rounds since RX last flowed, drives the backoff
+    ktime_t rx_fail_start;                  // Start of the current outage, 0 when healthy
+    bool rx_halted;                         // Bulk-in endpoint stalled (-EPIPE)
+    bool rx_stopped;                        // Interface going down, do not resubmit
+    struct bpf_prog __rcu *xdp_prog;        // Attached XDP program, if any
+    struct xdp_rxq_info xdp_rxq;
+    bool xdp_flush;                         // Redirects pending xdp_do_flush(), poll-local
+    bool monitor;                           // Interface is NL80211_IFTYPE_MONITOR
+
+    // Hardware RX filtering
+    struct rtl8811au_reg_shadow regs;       // Wanted register state, under rx_mode_lock
+    struct rtl8811au_reg_shadow hw_regs;    // Last state written to the chip, under reg_mutex
+    bool hw_regs_valid;                     // hw_regs matches the chip, under reg_mutex
+    spinlock_t rx_mode_lock;
+    struct mutex reg_mutex;                 // Serializes control transfers
+    struct work_struct rx_mode_work;        // Pushes regs to the chip
+    struct kthread_worker *tx_thread;       // TX kthread, one per device, runs worker + watchdog
+    cpumask_var_t tx_cpumask;               // CPUs tx_thread may run on (sysfs tx_cpumask)
     struct sk_buff_head tx_queue;           // Queue for outgoing packets
-    struct work_struct tx_worker_work;      // Work struct for TX worker
+    struct kthread_work tx_worker_work;     // Work struct for TX worker
     spinlock_t tx_queue_lock;               // Lock for tx_queue
     atomic_t tx_busy;                       // Flag: 1 if a TX URB is currently in flight
     struct sk_buff *tx_skb;                 // Pointer to the SKB currently being transmitted (FIXED)
+    struct sk_buff_head tx_agg_skbs;        // Frames copied into the aggregate in flight
+    struct usb_anchor tx_anchor;            // The TX URB in flight, for the watchdog to unlink
+    struct kthread_delayed_work tx_watchdog_work; // Armed while a TX URB is in flight
+
+    // TX coalescing, settings and window state under tx_queue_lock
+    u32 tx_coal_usecs;                      // 0: send every frame immediately
+    u32 tx_coal_frames;                     // Flush once this many frames are queued
+    unsigned int tx_coal_bytes;             // Bytes queued since the last flush
+    bool tx_coal_due;                       // Window closed, flush whatever is queued
+    struct hrtimer tx_coal_timer;
+    u8 *tx_agg_buf;                         // Aggregate being sent, allocated on first use
+    ktime_t tx_submit_time;                 // When the URB in flight was submitted
+    ktime_t tx_stall_start;                 // Submit time of the last unlinked URB, 0 when healthy
+    unsigned int tx_stall_count;            // Stalls since the last good completion
+
+    // Power management
+    bool suspended;                         // Between suspend and resume callbacks
+    bool suspend_auto;                      // The current suspend is a runtime one
+    bool rx_quiesced;                       // NAPI and RX stopped by quiesce, restarted by restore
+    ktime_t suspend_time;                   // When the last suspend completed
+    unsigned int autosuspend_ms;            // Adaptive autosuspend delay
+    struct work_struct autosuspend_work;    // Applies autosuspend_ms outside the PM callbacks
 
     // Spinlocks
     // spinlock_t tx_lock; // Removed, unused
@@ -52,6 +465,17 @@ struct rtl8811au_dev {
     // Dynamically discovered endpoints
     unsigned char bulk_in_endpoint;
     unsigned char bulk_out_endpoint;
+
+    // 802.3 <-> 802.11 encapsulation
+    u8 bssid[ETH_ALEN];                     // Placeholder, all zero: nothing associates yet
+    struct rtl8811au_hdr_cache __rcu *hdr_cache;
+    u16 tx_seq;                             // 802.11 sequence number, serialized by the xmit lock
+
+    // Link quality from the last decoded PHY status (read by cfg80211 get_station)
+    s8 last_rssi;
+    u8 last_rate;
+    struct rtl8811au_ext_stats ext_stats;   // Protected by stats_lock
+    struct rtl8811au_prof_stats __percpu *prof; // handler_timing, lockless
 };
 
 // USB Device ID table
@@ -65,15 +489,31 @@ MODULE_DEVICE_TABLE(usb, rtl8811au_table);
 static int rtl8811au_open(struct net_device *dev);
 static int rtl8811au_stop(struct net_device *dev);
 static netdev_tx_t rtl8811au_xmit(struct sk_buff *skb, struct net_device *dev);
-static void rtl8811au_tx_worker(struct work_struct *work);
+static void rtl8811au_tx_worker(struct kthread_work *work);
 static void rtl8811au_tx_complete(struct urb *urb);
 static void rtl8811au_rx_complete(struct urb *urb);
+static int rtl8811au_poll(struct napi_struct *napi, int budget);
+static int rtl8811au_rx_submit(struct rtl8811au_dev *priv, struct urb *urb, gfp_t gfp);
+static int rtl8811au_bpf(struct net_device *dev, struct netdev_bpf *bpf);
+static int rtl8811au_xdp_xmit(struct net_device *dev, int n, struct xdp_frame **frames, u32 flags);
 static int rtl8811au_set_mac_address(struct net_device *dev, void *addr);
+static void rtl8811au_set_rx_mode(struct net_device *dev);
+static void rtl8811au_tx_timeout(struct net_device *dev, unsigned int txqueue);
+static int rtl8811au_change_mtu(struct net_device *dev, int new_mtu);
+static inline void rtl8811au_kick_tx(struct rtl8811au_dev *priv);
+static void rtl8811au_rate_to_rate_info(u8 hw_rate, struct rate_info *ri);
+static int rtl8811au_update_hdr_cache(struct rtl8811au_dev *priv, const u8 *bssid);
+static void rtl8811au_autosuspend_work(struct work_struct *work);
+
+// The wiphy private area only holds a pointer back to the device context
+static inline struct rtl8811au_dev *rtl8811au_wiphy_priv(struct wiphy *wiphy) {
+    return *(struct rtl8811au_dev **)wiphy_priv(wiphy);
+}
 
 // --- cfg80211 Operations ---
 // NOTE: This is a placeholder. Real scan functionality is needed.
 static int rtl8811au_scan(struct wiphy *wiphy, struct cfg80211_scan_request *request) {
-    struct rtl8811au_dev *priv = wiphy_priv(wiphy); // Get priv pointer
+    struct rtl8811au_dev *priv = rtl8811au_wiphy_priv(wiphy); // Get priv pointer
     printk(KERN_INFO "%s: Scan requested (dummy)\n", priv->net_dev->name);
     // TODO: Implement actual hardware scan triggering
     // For now, just report scan finished (aborted) immediately
@@ -81,9 +521,52 @@ static int rtl8811au_scan(struct wiphy *wiphy, struct cfg80211_scan_request *req
     return 0; // Return 0 for success in initiating scan (even if dummy)
 }
 
+// Report link quality decoded from the RX PHY status
+static int rtl8811au_get_station(struct wiphy *wiphy, struct net_device *dev,
+                                 const u8 *mac, struct station_info *sinfo) {
+    struct rtl8811au_dev *priv = rtl8811au_wiphy_priv(wiphy);
+
+    sinfo->filled |= BIT_ULL(NL80211_STA_INFO_SIGNAL) |
+                     BIT_ULL(NL80211_STA_INFO_RX_BITRATE) |
+                     BIT_ULL(NL80211_STA_INFO_RX_PACKETS) |
+                     BIT_ULL(NL80211_STA_INFO_RX_BYTES);
+    sinfo->signal = READ_ONCE(priv->last_rssi);
+    rtl8811au_rate_to_rate_info(READ_ONCE(priv->last_rate), &sinfo->rxrate);
+    sinfo->rx_packets = dev->stats.rx_packets;
+    sinfo->rx_bytes = dev->stats.rx_bytes;
+    return 0;
+}
+
+// Switch between station and monitor; only allowed while the interface is down
+static int rtl8811au_change_iface(struct wiphy *wiphy, struct net_device *dev,
+                                  enum nl80211_iftype type, struct vif_params *params) {
+    struct rtl8811au_dev *priv = rtl8811au_wiphy_priv(wiphy);
+
+    if (netif_running(dev))
+        return -EBUSY;
+
+    switch (type) {
+    case NL80211_IFTYPE_STATION:
+        dev->type = ARPHRD_ETHER;
+        break;
+    case NL80211_IFTYPE_MONITOR:
+        dev->type = ARPHRD_IEEE80211_RADIOTAP;
+        break;
+    default:
+        return -EOPNOTSUPP;
+    }
+
+    dev->ieee80211_ptr->iftype = type;
+    WRITE_ONCE(priv->monitor, type == NL80211_IFTYPE_MONITOR);
+    printk(KERN_INFO "%s: Interface type changed to %d\n", dev->name, type);
+    return 0;
+}
+
 // NOTE: Add other necessary cfg80211 ops (connect, disconnect, set_channel, etc.)
 static struct cfg80211_ops rtl8811au_cfg80211_ops = {
     .scan = rtl8811au_scan,
+    .get_station = rtl8811au_get_station,
+    .change_virtual_intf = rtl8811au_change_iface,
     // .connect = rtl8811au_connect, // Example future op
     // .disconnect = rtl8811au_disconnect_station, // Example future op
     // .set_wiphy_params = rtl8811au_set_wiphy_params, // Example future op
@@ -95,15 +578,454 @@ static const struct net_device_ops rtl8811au_netdev_ops = {
     .ndo_stop = rtl8811au_stop,
     .ndo_start_xmit = rtl8811au_xmit,
     .ndo_set_mac_address = rtl8811au_set_mac_address,
+    .ndo_set_rx_mode = rtl8811au_set_rx_mode,
+    .ndo_tx_timeout = rtl8811au_tx_timeout,
+    .ndo_change_mtu = rtl8811au_change_mtu,
+    .ndo_bpf = rtl8811au_bpf,
+    .ndo_xdp_xmit = rtl8811au_xdp_xmit,
     // .ndo_get_stats64 = ..., // Consider implementing for detailed stats
 };
 
-// Wireless device structure associated with net_device
-static struct wireless_dev rtl8811au_wdev = {
-    .iftype = NL80211_IFTYPE_STATION,
-    // wiphy will be set during probe
+// --- Ethtool Operations ---
+static const struct {
+    char name[ETH_GSTRING_LEN];
+    size_t offset;
+} rtl8811au_ext_stats_desc[] = {
+#define RTL8811AU_EXT_STAT(field) { #field, offsetof(struct rtl8811au_ext_stats, field) }
+    RTL8811AU_EXT_STAT(rx_frames),
+    RTL8811AU_EXT_STAT(rx_crc_err),
+    RTL8811AU_EXT_STAT(rx_icv_err),
+    RTL8811AU_EXT_STAT(rx_desc_err),
+    RTL8811AU_EXT_STAT(rx_c2h),
+    RTL8811AU_EXT_STAT(rx_non_data),
+    RTL8811AU_EXT_STAT(rx_decap_err),
+    RTL8811AU_EXT_STAT(tx_encap_err),
+    RTL8811AU_EXT_STAT(tx_headroom_realloc),
+    RTL8811AU_EXT_STAT(rx_xdp_drop),
+    RTL8811AU_EXT_STAT(rx_xdp_tx),
+    RTL8811AU_EXT_STAT(rx_xdp_redirect),
+    RTL8811AU_EXT_STAT(rx_xdp_aborted),
+    RTL8811AU_EXT_STAT(tx_xdp_xmit),
+    RTL8811AU_EXT_STAT(tx_xdp_xmit_err),
+    RTL8811AU_EXT_STAT(rx_monitor),
+    RTL8811AU_EXT_STAT(rx_drop_nomem),
+    RTL8811AU_EXT_STAT(rx_drop_urb_err),
+    RTL8811AU_EXT_STAT(tx_drop_monitor),
+    RTL8811AU_EXT_STAT(hw_filter_writes),
+    RTL8811AU_EXT_STAT(hw_filter_err),
+    RTL8811AU_EXT_STAT(rx_recovery_rounds),
+    RTL8811AU_EXT_STAT(rx_recoveries),
+    RTL8811AU_EXT_STAT(rx_halt_clears),
+    RTL8811AU_EXT_STAT(rx_resets),
+    RTL8811AU_EXT_STAT(rx_recovery_last_us),
+    RTL8811AU_EXT_STAT(rx_recovery_max_us),
+    RTL8811AU_EXT_STAT(tx_agg_urbs),
+    RTL8811AU_EXT_STAT(tx_agg_frames),
+    RTL8811AU_EXT_STAT(tx_coal_timeouts),
+    RTL8811AU_EXT_STAT(tx_stalls),
+    RTL8811AU_EXT_STAT(tx_timeouts),
+    RTL8811AU_EXT_STAT(tx_stall_resets),
+    RTL8811AU_EXT_STAT(tx_stall_recovery_last_us),
+    RTL8811AU_EXT_STAT(tx_stall_recovery_max_us),
+    RTL8811AU_EXT_STAT(rx_buf_size),
+    RTL8811AU_EXT_STAT(rx_resizes),
+    RTL8811AU_EXT_STAT(pm_suspends),
+    RTL8811AU_EXT_STAT(pm_resumes),
+    RTL8811AU_EXT_STAT(pm_premature_wakes),
+    RTL8811AU_EXT_STAT(pm_autosuspend_ms),
+    RTL8811AU_EXT_STAT(pm_resume_last_us),
+    RTL8811AU_EXT_STAT(pm_resume_max_us),
+    RTL8811AU_EXT_STAT(pm_wake_last_us),
+    RTL8811AU_EXT_STAT(pm_wake_max_us),
+    RTL8811AU_EXT_STAT(rx_last_rate),
+    RTL8811AU_EXT_STAT(rx_last_pwdb),
+#undef RTL8811AU_EXT_STAT
+};
+
+// Reported after the table above, one time/units pair per handler
+static const char rtl8811au_prof_stats_desc[RTL8811AU_PROF_NUM][2][ETH_GSTRING_LEN] = {
+    [RTL8811AU_PROF_XMIT] = { "prof_xmit_ns", "prof_xmit_pkts" },
+    [RTL8811AU_PROF_TX_WORKER] = { "prof_tx_worker_ns", "prof_tx_worker_pkts" },
+    [RTL8811AU_PROF_TX_COMPLETE] = { "prof_tx_complete_ns", "prof_tx_complete_urbs" },
+    [RTL8811AU_PROF_RX_COMPLETE] = { "prof_rx_complete_ns", "prof_rx_complete_urbs" },
+    [RTL8811AU_PROF_RX_POLL] = { "prof_rx_poll_ns", "prof_rx_poll_frames" },
+};
+
+static int rtl8811au_get_sset_count(struct net_device *dev, int sset) {
+    if (sset == ETH_SS_STATS)
+        return ARRAY_SIZE(rtl8811au_ext_stats_desc) + RTL8811AU_PROF_NUM * 2;
+    return -EOPNOTSUPP;
+}
+
+static void rtl8811au_get_strings(struct net_device *dev, u32 sset, u8 *data) {
+    int i;
+
+    if (sset != ETH_SS_STATS)
+        return;
+    for (i = 0; i < ARRAY_SIZE(rtl8811au_ext_stats_desc); i++)
+        memcpy(data + i * ETH_GSTRING_LEN, rtl8811au_ext_stats_desc[i].name, ETH_GSTRING_LEN);
+    memcpy(data + i * ETH_GSTRING_LEN, rtl8811au_prof_stats_desc, sizeof(rtl8811au_prof_stats_desc));
+}
+
+static void rtl8811au_get_ethtool_stats(struct net_device *dev, struct ethtool_stats *estats, u64 *data) {
+    struct rtl8811au_dev *priv = netdev_priv(dev);
+    const struct rtl8811au_prof_stats *ps;
+    u64 ns[RTL8811AU_PROF_NUM], count[RTL8811AU_PROF_NUM];
+    unsigned long flags;
+    unsigned int start;
+    int i, h, cpu;
+
+    spin_lock_irqsave(&priv->stats_lock, flags);
+    for (i = 0; i < ARRAY_SIZE(rtl8811au_ext_stats_desc); i++)
+        data[i] = *(u64 *)((u8 *)&priv->ext_stats + rtl8811au_ext_stats_desc[i].offset);
+    spin_unlock_irqrestore(&priv->stats_lock, flags);
+
+    data += i;
+    memset(data, 0, RTL8811AU_PROF_NUM * 2 * sizeof(*data));
+    for_each_possible_cpu(cpu) {
+        ps = per_cpu_ptr(priv->prof, cpu);
+        do {
+            start = u64_stats_fetch_begin(&ps->syncp);
+            for (h = 0; h < RTL8811AU_PROF_NUM; h++) {
+                ns[h] = u64_stats_read(&ps->ns[h]);
+                count[h] = u64_stats_read(&ps->count[h]);
+            }
+        } while (u64_stats_fetch_retry(&ps->syncp, start));
+        for (h = 0; h < RTL8811AU_PROF_NUM; h++) {
+            data[h * 2] += ns[h];
+            data[h * 2 + 1] += count[h];
+        }
+    }
+}
+
+static int rtl8811au_get_coalesce(struct net_device *dev, struct ethtool_coalesce *ec,
+                                  struct kernel_ethtool_coalesce *kec, struct netlink_ext_ack *extack) {
+    struct rtl8811au_dev *priv = netdev_priv(dev);
+
+    ec->tx_coalesce_usecs = priv->tx_coal_usecs;
+    ec->tx_max_coalesced_frames = priv->tx_coal_frames;
+    return 0;
+}
+
+// Called under RTNL. tx-usecs 0 turns coalescing off; tx-frames 0 means no frame limit
+// (the aggregation buffer and RTL8811AU_TX_AGG_MAX_FRAMES still bound a transfer).
+static int rtl8811au_set_coalesce(struct net_device *dev, struct ethtool_coalesce *ec,
+                                  struct kernel_ethtool_coalesce *kec, struct netlink_ext_ack *extack) {
+    struct rtl8811au_dev *priv = netdev_priv(dev);
+    unsigned long flags;
+
+    if (ec->tx_coalesce_usecs > RTL8811AU_TX_COAL_MAX_USECS) {
+        NL_SET_ERR_MSG_MOD(extack, "tx-usecs too large");
+        return -EINVAL;
+    }
+    if (ec->tx_max_coalesced_frames > RTL8811AU_TX_AGG_MAX_FRAMES) {
+        NL_SET_ERR_MSG_MOD(extack, "tx-frames too large");
+        return -EINVAL;
+    }
+
+    // The buffer is kept once allocated: an aggregate may still be in flight
+    if (ec->tx_coalesce_usecs && !priv->tx_agg_buf) {
+        priv->tx_agg_buf = kmalloc(RTL8811AU_TX_AGG_BUF_SIZE, GFP_KERNEL);
+        if (!priv->tx_agg_buf)
+            return -ENOMEM;
+    }
+
+    spin_lock_irqsave(&priv->tx_queue_lock, flags);
+    priv->tx_coal_usecs = ec->tx_coalesce_usecs;
+    priv->tx_coal_frames = ec->tx_max_coalesced_frames ?: RTL8811AU_TX_AGG_MAX_FRAMES;
+    priv->tx_coal_due = true; // Whatever is queued goes out under the new settings
+    spin_unlock_irqrestore(&priv->tx_queue_lock, flags);
+
+    hrtimer_cancel(&priv->tx_coal_timer);
+    if (netif_running(dev))
+        rtl8811au_kick_tx(priv);
+    return 0;
+}
+
+static const struct ethtool_ops rtl8811au_ethtool_ops = {
+    .supported_coalesce_params = ETHTOOL_COALESCE_TX_USECS | ETHTOOL_COALESCE_TX_MAX_FRAMES,
+    .get_link = ethtool_op_get_link,
+    .get_sset_count = rtl8811au_get_sset_count,
+    .get_strings = rtl8811au_get_strings,
+    .get_ethtool_stats = rtl8811au_get_ethtool_stats,
+    .get_coalesce = rtl8811au_get_coalesce,
+    .set_coalesce = rtl8811au_set_coalesce,
 };
 
+// --- Handler Timing ---
+// rtl8811au_prof_start() returns 0 when handler_timing is off, which makes the matching
+// rtl8811au_prof_end() a no-op. ns / count in ethtool -S is the per-unit handler cost.
+static inline u64 rtl8811au_prof_start(void) {
+    return unlikely(READ_ONCE(handler_timing)) ? ktime_get_ns() : 0;
+}
+
+// Handlers run in process, BH and hard IRQ context; the irqsave variant keeps a
+// completion from interrupting an update on the same CPU (32-bit only, free on 64-bit)
+static inline void rtl8811au_prof_end(struct rtl8811au_dev *priv, u64 start,
+                                      enum rtl8811au_prof_handler h, unsigned int n) {
+    struct rtl8811au_prof_stats *ps;
+    unsigned long flags;
+    u64 delta;
+
+    if (likely(!start))
+        return;
+    delta = ktime_get_ns() - start;
+    ps = get_cpu_ptr(priv->prof);
+    flags = u64_stats_update_begin_irqsave(&ps->syncp);
+    u64_stats_add(&ps->ns[h], delta);
+    u64_stats_add(&ps->count[h], n);
+    u64_stats_update_end_irqrestore(&ps->syncp, flags);
+    put_cpu_ptr(priv->prof);
+}
+
+// --- Register Access (process context) ---
+static int rtl8811au_write_reg(struct rtl8811au_dev *priv, u16 addr, const void *val, u16 len) {
+    return usb_control_msg_send(priv->usb_dev, 0, RTL8811AU_USB_REQ_VENDOR, RTL8811AU_USB_REQ_WRITE,
+                                addr, 0, val, len, RTL8811AU_USB_CTRL_TIMEOUT, GFP_KERNEL);
+}
+
+static int rtl8811au_read_reg(struct rtl8811au_dev *priv, u16 addr, void *val, u16 len) {
+    return usb_control_msg_recv(priv->usb_dev, 0, RTL8811AU_USB_REQ_VENDOR, RTL8811AU_USB_REQ_READ,
+                                addr, 0, val, len, RTL8811AU_USB_CTRL_TIMEOUT, GFP_KERNEL);
+}
+
+static int rtl8811au_write32(struct rtl8811au_dev *priv, u16 addr, u32 val) {
+    __le32 v = cpu_to_le32(val);
+
+    return rtl8811au_write_reg(priv, addr, &v, sizeof(v));
+}
+
+static int __maybe_unused rtl8811au_read32(struct rtl8811au_dev *priv, u16 addr, u32 *val) {
+    __le32 v;
+    int ret;
+
+    ret = rtl8811au_read_reg(priv, addr, &v, sizeof(v));
+    if (!ret)
+        *val = le32_to_cpu(v);
+    return ret;
+}
+
+// Write every shadowed register that differs from what the chip holds, or all of them
+// when `force` is set (the chip may have lost its state) or hw_regs is not known to
+// match the chip yet (after probe or a reset). Caller holds reg_mutex.
+static int rtl8811au_write_shadow(struct rtl8811au_dev *priv, const struct rtl8811au_reg_shadow *want, bool force) {
+    struct rtl8811au_reg_shadow *hw = &priv->hw_regs;
+    int writes = 0;
+    int ret = 0;
+
+    lockdep_assert_held(&priv->reg_mutex);
+
+    // A zeroed hw_regs would otherwise skip zero-valued registers on the first write
+    if (!priv->hw_regs_valid)
+        force = true;
+
+    if (force || memcmp(want->macid, hw->macid, ETH_ALEN)) {
+        ret = rtl8811au_write_reg(priv, REG_MACID, want->macid, ETH_ALEN);
+        if (ret)
+            goto out;
+        memcpy(hw->macid, want->macid, ETH_ALEN);
+        writes++;
+    }
+    if (force || memcmp(want->bssid, hw->bssid, ETH_ALEN)) {
+        ret = rtl8811au_write_reg(priv, REG_BSSID, want->bssid, ETH_ALEN);
+        if (ret)
+            goto out;
+        memcpy(hw->bssid, want->bssid, ETH_ALEN);
+        writes++;
+    }
+    if (force || memcmp(want->mar, hw->mar, sizeof(want->mar))) {
+        ret = rtl8811au_write_reg(priv, REG_MAR, want->mar, sizeof(want->mar));
+        if (ret)
+            goto out;
+        memcpy(hw->mar, want->mar, sizeof(want->mar));
+        writes++;
+    }
+    if (force || want->rcr != hw->rcr) {
+        ret = rtl8811au_write32(priv, REG_RCR, want->rcr);
+        if (ret)
+            goto out;
+        hw->rcr = want->rcr;
+        writes++;
+    }
+    priv->hw_regs_valid = true; // Only after a complete pass
+
+out:
+    if (writes || ret) {
+        unsigned long flags;
+
+        spin_lock_irqsave(&priv->stats_lock, flags);
+        priv->ext_stats.hw_filter_writes += writes;
+        if (ret)
+            priv->ext_stats.hw_filter_err++;
+        spin_unlock_irqrestore(&priv->stats_lock, flags);
+    }
+    return ret;
+}
+
+// Work item: push the wanted filter state to the chip
+static void rtl8811au_rx_mode_work(struct work_struct *work) {
+    struct rtl8811au_dev *priv = container_of(work, struct rtl8811au_dev, rx_mode_work);
+    struct rtl8811au_reg_shadow want;
+    unsigned long flags;
+    int ret;
+
+    if (!priv->usb_dev)
+        return;
+
+    spin_lock_irqsave(&priv->rx_mode_lock, flags);
+    want = priv->regs;
+    spin_unlock_irqrestore(&priv->rx_mode_lock, flags);
+
+    // Wakes the device if needed. When it cannot (system sleep), resume writes the
+    // whole shadow anyway.
+    if (usb_autopm_get_interface(priv->usb_intf))
+        return;
+
+    mutex_lock(&priv->reg_mutex);
+    ret = rtl8811au_write_shadow(priv, &want, false);
+    mutex_unlock(&priv->reg_mutex);
+    usb_autopm_put_interface(priv->usb_intf);
+
+    if (ret)
+        printk_ratelimited(KERN_ERR "%s: Failed to program RX filters (error %d)\n", priv->net_dev->name, ret);
+}
+
+// --- Buffer Sizing ---
+// Derive TX limits and the bulk-in buffer size from the MTU, the negotiated bus speed
+// and the endpoint's wMaxPacketSize. Sets the TX limits, returns the RX buffer size.
+static unsigned int rtl8811au_size_buffers(struct rtl8811au_dev *priv, unsigned int mtu) {
+    unsigned int frame = RTL8811AU_FRAME_OVERHEAD + ETH_HLEN + mtu;
+    unsigned int frames, cap, size;
+    unsigned long flags;
+
+    switch (priv->usb_dev->speed) {
+    case USB_SPEED_SUPER:
+    case USB_SPEED_SUPER_PLUS:
+        frames = RTL8811AU_AGG_FRAMES_SS;
+        cap = RTL8811AU_AGG_CAP_SS;
+        break;
+    case USB_SPEED_HIGH:
+        frames = RTL8811AU_AGG_FRAMES_HS;
+        cap = RTL8811AU_AGG_CAP_HS;
+        break;
+    default:
+        frames = RTL8811AU_AGG_FRAMES_FS;
+        cap = RTL8811AU_AGG_CAP_FS;
+        break;
+    }
+
+    // Whole packets, so a full buffer ends on a packet boundary; never below one frame
+    size = min(frames * frame, cap);
+    size = roundup(max(size, frame), priv->bulk_in_maxp ?: 512);
+
+    // TX: descriptor + 802.11 + LLC/SNAP in front of the Ethernet payload
+    spin_lock_irqsave(&priv->tx_queue_lock, flags);
+    priv->tx_max_len = sizeof(struct rtl8811au_tx_hdr) + mtu;
+    priv->tx_agg_size = clamp_t(unsigned int, rounddown(cap / 2, priv->bulk_out_maxp ?: 512),
+                                priv->tx_max_len, RTL8811AU_TX_AGG_BUF_SIZE);
+    spin_unlock_irqrestore(&priv->tx_queue_lock, flags);
+
+    spin_lock_irqsave(&priv->stats_lock, flags);
+    priv->ext_stats.rx_buf_size = size;
+    spin_unlock_irqrestore(&priv->stats_lock, flags);
+    return size;
+}
+
+// --- RX URB Pool ---
+// A pool is an array of RTL8811AU_NUM_RX_URBS URBs, normally priv->rx_urbs; an MTU change
+// builds the new pool on the side and swaps it in.
+static void rtl8811au_free_rx_urbs(struct rtl8811au_dev *priv, struct urb **urbs) {
+    struct urb *urb;
+    int i;
+
+    for (i = 0; i < RTL8811AU_NUM_RX_URBS; i++) {
+        urb = urbs[i];
+        if (!urb)
+            continue;
+        usb_free_coherent(priv->usb_dev, urb->transfer_buffer_length,
+                          urb->transfer_buffer, urb->transfer_dma);
+        usb_free_urb(urb);
+        urbs[i] = NULL;
+    }
+}
+
+// Exchange priv->rx_urbs with a side pool; neither may be in flight
+static void rtl8811au_swap_rx_urbs(struct rtl8811au_dev *priv, struct urb **urbs) {
+    int i;
+
+    for (i = 0; i < RTL8811AU_NUM_RX_URBS; i++)
+        swap(priv->rx_urbs[i], urbs[i]);
+}
+
+static int rtl8811au_alloc_rx_urbs(struct rtl8811au_dev *priv, struct urb **urbs, unsigned int size) {
+    struct urb *urb;
+    dma_addr_t dma;
+    void *buf;
+    int i;
+
+    for (i = 0; i < RTL8811AU_NUM_RX_URBS; i++) {
+        urb = usb_alloc_urb(0, GFP_KERNEL);
+        if (!urb)
+            goto err_free;
+
+        // DMA coherent buffer, reused for the lifetime of the URB
+        buf = usb_alloc_coherent(priv->usb_dev, size, GFP_KERNEL, &dma);
+        if (!buf) {
+            usb_free_urb(urb);
+            goto err_free;
+        }
+
+        usb_fill_bulk_urb(urb, priv->usb_dev,
+                          usb_rcvbulkpipe(priv->usb_dev, priv->bulk_in_endpoint),
+                          buf, size,
+                          rtl8811au_rx_complete, priv);
+        urb->transfer_flags |= URB_NO_TRANSFER_DMA_MAP; // Use pre-allocated coherent buffer
+        urb->transfer_dma = dma;
+        urbs[i] = urb;
+    }
+    return 0;
+
+err_free:
+    rtl8811au_free_rx_urbs(priv, urbs);
+    return -ENOMEM;
+}
+
+// Cancel every submitted RX URB. NAPI must already be disabled so nothing resubmits
+// from poll; rx_stopped keeps completions and the recovery work from doing so.
+static void rtl8811au_kill_rx_urbs(struct rtl8811au_dev *priv) {
+    spin_lock_irq(&priv->rx_done_lock);
+    priv->rx_stopped = true;
+    spin_unlock_irq(&priv->rx_done_lock);
+
+    cancel_delayed_work_sync(&priv->rx_recovery_work);
+    usb_kill_anchored_urbs(&priv->rx_anchor);
+
+    // Anything left on these lists is no longer in flight
+    INIT_LIST_HEAD(&priv->rx_done);
+    INIT_LIST_HEAD(&priv->rx_refill);
+}
+
+static int rtl8811au_start_rx(struct rtl8811au_dev *priv) {
+    int i, ret;
+
+    spin_lock_irq(&priv->rx_done_lock);
+    priv->rx_stopped = false;
+    priv->rx_halted = false;
+    spin_unlock_irq(&priv->rx_done_lock);
+    priv->rx_error_count = 0;
+    priv->rx_recovery_attempts = 0;
+    priv->rx_fail_start = 0;
+
+    for (i = 0; i < RTL8811AU_NUM_RX_URBS; i++) {
+        ret = rtl8811au_rx_submit(priv, priv->rx_urbs[i], GFP_KERNEL);
+        if (ret) {
+            rtl8811au_kill_rx_urbs(priv);
+            return ret;
+        }
+    }
+    return 0;
+}
+
 // --- Open Function ---
 static int rtl8811au_open(struct net_device *dev) {
     struct rtl8811au_dev *priv = netdev_priv(dev);
@@ -125,78 +1047,198 @@ static int rtl8811au_open(struct net_device *dev) {
         return -ENODEV;
     }
 
-    // Allocate RX URB
-    priv->rx_urb = usb_alloc_urb(0, GFP_KERNEL);
-    if (!priv->rx_urb) {
-        printk(KERN_ERR "%s: Failed to allocate RX URB\n", dev->name);
-        return -ENOMEM;
+    // Keep the device awake while bringing it up
+    ret = usb_autopm_get_interface(priv->usb_intf);
+    if (ret) {
+        printk(KERN_ERR "%s: Failed to resume device (error %d)\n", dev->name, ret);
+        return ret;
     }
 
-    // Allocate RX buffer (DMA coherent)
-    priv->rx_buffer = usb_alloc_coherent(priv->usb_dev, MAX_PACKET_SIZE, GFP_KERNEL, &priv->rx_dma);
-    if (!priv->rx_buffer) {
-        printk(KERN_ERR "%s: Failed to allocate RX buffer\n", dev->name);
-        usb_free_urb(priv->rx_urb);
-        priv->rx_urb = NULL;
-        return -ENOMEM;
+    // Build the TX header template (placeholder BSSID, see rtl8811au_hdr_cache)
+    ret = rtl8811au_update_hdr_cache(priv, priv->bssid);
+    if (ret) {
+        printk(KERN_ERR "%s: Failed to build TX header template\n", dev->name);
+        goto err_autopm;
     }
 
-    // Fill the RX URB
-    usb_fill_bulk_urb(priv->rx_urb, priv->usb_dev,
-                      usb_rcvbulkpipe(priv->usb_dev, priv->bulk_in_endpoint),
-                      priv->rx_buffer, MAX_PACKET_SIZE,
-                      rtl8811au_rx_complete, priv);
-    priv->rx_urb->transfer_flags |= URB_NO_TRANSFER_DMA_MAP; // Use pre-allocated coherent buffer
-    priv->rx_urb->transfer_dma = priv->rx_dma;
+    // Own address and BSSID filters; RCR and MAR follow from ndo_set_rx_mode after open
+    spin_lock_irq(&priv->rx_mode_lock);
+    memcpy(priv->regs.macid, dev->dev_addr, ETH_ALEN);
+    memcpy(priv->regs.bssid, priv->bssid, ETH_ALEN);
+    spin_unlock_irq(&priv->rx_mode_lock);
+    queue_work(priv->wq, &priv->rx_mode_work);
+
+    // RX queue info for XDP; frames live in page fragments (see rtl8811au_rx_frame)
+    ret = xdp_rxq_info_reg(&priv->xdp_rxq, dev, 0, priv->napi.napi_id);
+    if (ret) {
+        printk(KERN_ERR "%s: Failed to register XDP RX queue (error %d)\n", dev->name, ret);
+        goto err_autopm;
+    }
+    ret = xdp_rxq_info_reg_mem_model(&priv->xdp_rxq, MEM_TYPE_PAGE_SHARED, NULL);
+    if (ret) {
+        printk(KERN_ERR "%s: Failed to register XDP memory model (error %d)\n", dev->name, ret);
+        goto err_unreg_rxq;
+    }
 
+    // Allocate the RX URB pool, sized for this MTU and bus
+    priv->rx_buf_size = rtl8811au_size_buffers(priv, dev->mtu);
+    ret = rtl8811au_alloc_rx_urbs(priv, priv->rx_urbs, priv->rx_buf_size);
+    if (ret) {
+        printk(KERN_ERR "%s: Failed to allocate RX URBs\n", dev->name);
+        goto err_unreg_rxq;
+    }
 
-    // Submit the initial RX URB
+    // Submit the initial RX URBs
     priv->rx_error_count = 0; // Reset error count on open
-    //ret = usb_submit_urb(priv->rx_urb, GFP_KERNEL);
-    /*if (ret) {
-        printk(KERN_ERR "%s: Failed to submit initial RX URB (error %d)\n", dev->name, ret);
-        usb_free_coherent(priv->usb_dev, MAX_PACKET_SIZE, priv->rx_buffer, priv->rx_dma);
-        usb_free_urb(priv->rx_urb);
-        priv->rx_urb = NULL;
-        priv->rx_buffer = NULL;
-        return ret;
-    }*/
+    napi_enable(&priv->napi);
+    ret = rtl8811au_start_rx(priv);
+    if (ret) {
+        printk(KERN_ERR "%s: Failed to submit initial RX URBs (error %d)\n", dev->name, ret);
+        napi_disable(&priv->napi);
+        rtl8811au_free_rx_urbs(priv, priv->rx_urbs);
+        goto err_unreg_rxq;
+    }
 
     // Start the network queue (allows xmit function to be called)
     netif_start_queue(dev);
+    if (!skb_queue_empty(&priv->tx_queue))
+        rtl8811au_kick_tx(priv); // Frames left over from before stop
     printk(KERN_INFO "%s: Network queue started\n", dev->name);
+
+    // Idle from here on may autosuspend; incoming frames wake the device remotely
+    priv->usb_intf->needs_remote_wakeup = 1;
+    usb_autopm_put_interface(priv->usb_intf);
+    return 0;
+
+err_unreg_rxq:
+    xdp_rxq_info_unreg(&priv->xdp_rxq);
+err_autopm:
+    usb_autopm_put_interface(priv->usb_intf);
+    return ret;
+}
+
+// --- MTU Change ---
+// Called under RTNL. While the interface is up, a new RX pool is allocated for the new
+// buffer size and swapped in: RX pauses only for the swap, TX keeps running. If the
+// allocation fails, or the new pool cannot be started, the old pool goes back in at the
+// old MTU and the error is returned.
+static int rtl8811au_change_mtu(struct net_device *dev, int new_mtu) {
+    struct rtl8811au_dev *priv = netdev_priv(dev);
+    struct urb *urbs[RTL8811AU_NUM_RX_URBS] = {};
+    unsigned int old_mtu = dev->mtu;
+    unsigned int size;
+    unsigned long flags;
+    int ret;
+
+    if (rcu_access_pointer(priv->xdp_prog) && new_mtu > RTL8811AU_XDP_MAX_MTU) {
+        printk(KERN_ERR "%s: MTU %d too large while an XDP program is attached\n", dev->name, new_mtu);
+        return -EINVAL;
+    }
+
+    if (!netif_running(dev)) {
+        WRITE_ONCE(dev->mtu, new_mtu);
+        return 0; // Sized at open
+    }
+
+    ret = usb_autopm_get_interface(priv->usb_intf); // No suspend while the pool is swapped
+    if (ret)
+        return ret;
+
+    size = rtl8811au_size_buffers(priv, new_mtu);
+    if (size != priv->rx_buf_size) {
+        ret = rtl8811au_alloc_rx_urbs(priv, urbs, size);
+        if (ret) {
+            printk(KERN_ERR "%s: Failed to resize RX buffers for MTU %d\n", dev->name, new_mtu);
+            rtl8811au_size_buffers(priv, old_mtu); // TX limits back to the old MTU
+            usb_autopm_put_interface(priv->usb_intf);
+            return ret;
+        }
+
+        // Swap pools; the old one is kept until the new one is running
+        napi_disable(&priv->napi);
+        rtl8811au_kill_rx_urbs(priv);
+        rtl8811au_swap_rx_urbs(priv, urbs);
+        swap(priv->rx_buf_size, size);
+
+        napi_enable(&priv->napi);
+        ret = rtl8811au_start_rx(priv);
+        if (ret) {
+            // start_rx has already killed what it submitted; go back to the old pool
+            printk(KERN_ERR "%s: Failed to restart RX after MTU change (error %d), keeping MTU %u\n",
+                   dev->name, ret, old_mtu);
+            napi_disable(&priv->napi);
+            rtl8811au_swap_rx_urbs(priv, urbs);
+            swap(priv->rx_buf_size, size);
+            rtl8811au_size_buffers(priv, old_mtu); // TX limits back to the old MTU
+            napi_enable(&priv->napi);
+            if (rtl8811au_start_rx(priv))
+                printk(KERN_ERR "%s: Failed to restart RX on the old buffers\n", dev->name);
+        }
+        rtl8811au_free_rx_urbs(priv, urbs); // Whichever pool is not in use
+        if (ret) {
+            usb_autopm_put_interface(priv->usb_intf);
+            return ret;
+        }
+
+        spin_lock_irqsave(&priv->stats_lock, flags);
+        priv->ext_stats.rx_resizes++;
+        spin_unlock_irqrestore(&priv->stats_lock, flags);
+    }
+    usb_autopm_put_interface(priv->usb_intf);
+
+    WRITE_ONCE(dev->mtu, new_mtu);
+    printk(KERN_INFO "%s: MTU %u -> %d, RX buffers %u bytes\n", dev->name, old_mtu, new_mtu, priv->rx_buf_size);
     return 0;
 }
 
 // --- Stop Function ---
 static int rtl8811au_stop(struct net_device *dev) {
     struct rtl8811au_dev *priv = netdev_priv(dev);
+    int pm_ret;
     printk(KERN_INFO "%s: Stopping network device\n", dev->name);
 
+    // Wake the device so resume re-enables NAPI before it is disabled below. If it
+    // cannot wake, quiesce has already disabled NAPI and killed the RX URBs.
+    pm_ret = usb_autopm_get_interface(priv->usb_intf);
+    if (pm_ret)
+        printk(KERN_WARNING "%s: Failed to resume device for stop (error %d)\n", dev->name, pm_ret);
+
     // Stop the network queue (prevents new transmissions)
     netif_stop_queue(dev);
 
-    // Kill the pending RX URB
-    // Needs to be done before freeing buffer
-    if (priv->rx_urb) {
-        usb_kill_urb(priv->rx_urb); // Wait until URB is not running
+    // Disarm the TX watchdog and cancel the URB in flight; queued frames stay for the next open
+    hrtimer_cancel(&priv->tx_coal_timer);
+    spin_lock_irq(&priv->tx_queue_lock);
+    priv->tx_coal_due = true; // Coalesced frames left over go out right after the next open
+    spin_unlock_irq(&priv->tx_queue_lock);
+    kthread_cancel_delayed_work_sync(&priv->tx_watchdog_work);
+    usb_kill_anchored_urbs(&priv->tx_anchor);
+
+    if (!priv->rx_quiesced) {
+        // Stop polling first so the poll loop cannot resubmit a URB we are about to kill
+        napi_disable(&priv->napi);
+
+        // Kill the pending RX URBs
+        // Needs to be done before freeing buffers
+        rtl8811au_kill_rx_urbs(priv);
     }
+    priv->rx_quiesced = false; // The pool is freed below; a later resume must not restart it
+    xdp_rxq_info_unreg(&priv->xdp_rxq);
 
     // --- Workqueue cleanup moved to disconnect ---
-    // cancel_work_sync(&priv->tx_worker_work); // Ensure TX worker isn't running
-    // flush_workqueue(priv->tx_wq); // Ensure queue is empty
-    // destroy_workqueue(priv->tx_wq); // FIXED: Moved to disconnect
-    // priv->tx_wq = NULL;
+    // kthread_cancel_work_sync(&priv->tx_worker_work); // Ensure TX worker isn't running
+    // kthread_destroy_worker(priv->tx_thread); // FIXED: Moved to disconnect
 
     // Free RX resources
-    if (priv->rx_urb) {
-        usb_free_urb(priv->rx_urb);
-        priv->rx_urb = NULL;
-    }
-    if (priv->rx_buffer) {
-        usb_free_coherent(priv->usb_dev, MAX_PACKET_SIZE, priv->rx_buffer, priv->rx_dma);
-        priv->rx_buffer = NULL;
-    }
+    rtl8811au_free_rx_urbs(priv, priv->rx_urbs);
+
+    // Let a pending filter update finish; the chip keeps its filters while down
+    cancel_work_sync(&priv->rx_mode_work);
+
+    // Nothing to wake up for while down
+    priv->usb_intf->needs_remote_wakeup = 0;
+    if (!pm_ret)
+        usb_autopm_put_interface(priv->usb_intf);
 
     // TODO: Add hardware de-initialization commands if necessary
 
@@ -204,65 +1246,556 @@ static int rtl8811au_stop(struct net_device *dev) {
     return 0;
 }
 
-// --- Transmit Function (called by kernel) ---
-static netdev_tx_t rtl8811au_xmit(struct sk_buff *skb, struct net_device *dev) {
-    struct rtl8811au_dev *priv = netdev_priv(dev);
+// --- 802.3 -> 802.11 Encapsulation ---
+// (Re)build the cached TX header for the given BSSID. Called under RTNL at open and when
+// our own address changes; readers in the xmit path use RCU.
+static int rtl8811au_update_hdr_cache(struct rtl8811au_dev *priv, const u8 *bssid) {
+    struct rtl8811au_hdr_cache *cache, *old;
+    struct rtl8811au_tx_hdr *t;
+
+    cache = kzalloc(sizeof(*cache), GFP_KERNEL);
+    if (!cache)
+        return -ENOMEM;
+
+    memcpy(cache->bssid, bssid, ETH_ALEN);
+    t = &cache->tmpl;
+    t->desc.dw0 = cpu_to_le32(FIELD_PREP(TX_DESC_DW0_OFFSET, RTL8811AU_TX_DESC_SIZE) |
+                              TX_DESC_DW0_FS | TX_DESC_DW0_LS | TX_DESC_DW0_OWN);
+    t->desc.dw1 = cpu_to_le32(FIELD_PREP(TX_DESC_DW1_MACID, 0) |
+                              FIELD_PREP(TX_DESC_DW1_RATE_ID, RTL8811AU_RATEID_BGN_20M));
+    // Station mode: To-DS, addr1 = BSSID, addr2 = our address, addr3 = final destination
+    t->hdr.frame_control = cpu_to_le16(IEEE80211_FTYPE_DATA | IEEE80211_STYPE_DATA |
+                                       IEEE80211_FCTL_TODS);
+    memcpy(t->hdr.addr1, bssid, ETH_ALEN);
+    memcpy(t->hdr.addr2, priv->net_dev->dev_addr, ETH_ALEN);
+    memcpy(t->llc_snap, rfc1042_header, sizeof(t->llc_snap));
+
+    old = rtnl_dereference(priv->hdr_cache);
+    rcu_assign_pointer(priv->hdr_cache, cache);
+    if (old)
+        kfree_rcu(old, rcu);
+    return 0;
+}
+
+// Descriptor checksum: XOR of the first 32 bytes taken as 16-bit words
+static inline void rtl8811au_tx_desc_checksum(struct rtl8811au_tx_desc *desc) {
+    const __le16 *word = (const __le16 *)desc;
+    u16 csum = 0;
+    int i;
+
+    desc->dw7 &= ~cpu_to_le32(TX_DESC_DW7_CHECKSUM);
+    for (i = 0; i < 16; i++)
+        csum ^= le16_to_cpu(word[i]);
+    desc->dw7 |= cpu_to_le32(FIELD_PREP(TX_DESC_DW7_CHECKSUM, csum));
+}
+
+// Replace the Ethernet header with TX descriptor + 802.11 header + LLC/SNAP, in place in
+// skb headroom. net_dev->needed_headroom makes the stack reserve the extra bytes, so
+// skb_cow_head() only reallocates for cloned or foreign skbs.
+static int rtl8811au_tx_encap(struct rtl8811au_dev *priv, struct sk_buff *skb) {
+    const struct rtl8811au_hdr_cache *cache;
+    struct rtl8811au_tx_hdr *th;
+    struct ethhdr eth;
+    unsigned int hdr_len;
     unsigned long flags;
+    bool snap;
+    u32 dw0;
 
-    // Don't transmit if device is not running or being removed
-    if (!netif_running(dev) || !priv || !priv->tx_wq) {
-        dev_kfree_skb_any(skb); // Free the skb
-        dev->stats.tx_dropped++;
-        return NETDEV_TX_OK;
+    if (unlikely(skb->len < ETH_HLEN))
+        return -EINVAL;
+    memcpy(&eth, skb->data, ETH_HLEN); // Overwritten by the push below
+
+    // 802.3 length-field frames already carry their own LLC header
+    snap = ntohs(eth.h_proto) >= ETH_P_802_3_MIN;
+    hdr_len = snap ? sizeof(*th) : offsetof(struct rtl8811au_tx_hdr, llc_snap);
+
+    if (unlikely(skb_headroom(skb) < hdr_len - ETH_HLEN || skb_header_cloned(skb))) {
+        spin_lock_irqsave(&priv->stats_lock, flags);
+        priv->ext_stats.tx_headroom_realloc++;
+        spin_unlock_irqrestore(&priv->stats_lock, flags);
+        if (skb_cow_head(skb, hdr_len - ETH_HLEN))
+            return -ENOMEM;
     }
 
-    // Check if TX endpoint exists
-    if (priv->bulk_out_endpoint == 0) {
-         printk_once(KERN_ERR "%s: No bulk OUT endpoint for TX!\n", dev->name);
-         dev_kfree_skb_any(skb);
-         dev->stats.tx_dropped++;
-         return NETDEV_TX_OK;
+    rcu_read_lock();
+    cache = rcu_dereference(priv->hdr_cache);
+    if (unlikely(!cache)) {
+        rcu_read_unlock();
+        return -ENOLINK;
+    }
+    th = skb_push(skb, hdr_len - ETH_HLEN);
+    memcpy(th, &cache->tmpl, hdr_len);
+    rcu_read_unlock();
+
+    dw0 = le32_to_cpu(th->desc.dw0) | FIELD_PREP(TX_DESC_DW0_PKT_SIZE, skb->len - RTL8811AU_TX_DESC_SIZE);
+    if (is_multicast_ether_addr(eth.h_dest))
+        dw0 |= TX_DESC_DW0_BMC;
+    th->desc.dw0 = cpu_to_le32(dw0);
+    th->desc.dw1 |= cpu_to_le32(FIELD_PREP(TX_DESC_DW1_QSEL, skb->priority & IEEE80211_QOS_CTL_TID_MASK));
+    th->desc.dw9 = cpu_to_le32(FIELD_PREP(TX_DESC_DW9_SEQ, priv->tx_seq));
+    th->hdr.seq_ctrl = cpu_to_le16(IEEE80211_SN_TO_SEQ(priv->tx_seq));
+    priv->tx_seq = ieee80211_sn_inc(priv->tx_seq);
+    memcpy(th->hdr.addr3, eth.h_dest, ETH_ALEN);
+    if (snap)
+        th->ethertype = eth.h_proto;
+    rtl8811au_tx_desc_checksum(&th->desc);
+    return 0;
+}
+
+// --- TX Queueing ---
+// Schedule the TX worker on the device's TX thread
+static inline void rtl8811au_kick_tx(struct rtl8811au_dev *priv) {
+    kthread_queue_work(priv->tx_thread, &priv->tx_worker_work);
+}
+
+// Encapsulate one frame and queue it for the TX worker. Shared by ndo_start_xmit and the
+// XDP transmit paths, which all run under the netdev TX queue lock. Always consumes skb.
+static void rtl8811au_tx_enqueue(struct rtl8811au_dev *priv, struct sk_buff *skb) {
+    struct net_device *dev = priv->net_dev;
+    unsigned long flags;
+    bool coalesce, flush_now = false, open_window = false;
+
+    // Convert to 802.11 in place before queueing; the worker submits skb->data as-is
+    if (rtl8811au_tx_encap(priv, skb)) {
+        dev_kfree_skb_any(skb);
+        spin_lock_irqsave(&priv->stats_lock, flags);
+        dev->stats.tx_dropped++;
+        priv->ext_stats.tx_encap_err++;
+        spin_unlock_irqrestore(&priv->stats_lock, flags);
+        return;
     }
 
     // Queue the packet
     spin_lock_irqsave(&priv->tx_queue_lock, flags);
     // Basic backpressure: Stop queue if it gets too long
-    if (skb_queue_len(&priv->tx_queue) > 100) { // Example queue limit
+    if (skb_queue_len(&priv->tx_queue) > RTL8811AU_TX_QUEUE_STOP) {
+        // We still queue the packet; the stopped queue holds back further xmits.
+        // Returning NETDEV_TX_BUSY here would make the stack resend an skb we already own.
         netif_stop_queue(dev);
-        // We still queue the packet but signal TX busy to the kernel
-        skb_queue_tail(&priv->tx_queue, skb);
-        spin_unlock_irqrestore(&priv->tx_queue_lock, flags);
         printk(KERN_DEBUG "%s: TX queue full, stopping queue\n", dev->name);
-        return NETDEV_TX_BUSY; // Indicate busy, kernel will retry later
     }
 
     // Add packet to the queue
     skb_queue_tail(&priv->tx_queue, skb);
+    coalesce = priv->tx_coal_usecs != 0;
+    if (coalesce) {
+        priv->tx_coal_bytes += ALIGN(skb->len, RTL8811AU_TX_AGG_ALIGN);
+        flush_now = priv->tx_coal_due || skb_queue_len(&priv->tx_queue) >= priv->tx_coal_frames ||
+                    priv->tx_coal_bytes + priv->tx_max_len > priv->tx_agg_size;
+        open_window = skb_queue_len(&priv->tx_queue) == 1 && !priv->tx_coal_due;
+    }
     spin_unlock_irqrestore(&priv->tx_queue_lock, flags);
 
+    if (coalesce) {
+        // First frame of a window starts the timer; a full window goes out right away
+        if (flush_now)
+            rtl8811au_kick_tx(priv);
+        else if (open_window)
+            hrtimer_start(&priv->tx_coal_timer, us_to_ktime(priv->tx_coal_usecs), HRTIMER_MODE_REL);
+        return;
+    }
+
     // Schedule the worker if it's not already busy processing a previous URB
     if (atomic_read(&priv->tx_busy) == 0) {
-        queue_work(priv->tx_wq, &priv->tx_worker_work);
+        rtl8811au_kick_tx(priv);
     }
-
-    return NETDEV_TX_OK; // Packet accepted
 }
 
-// --- TX Worker Function (runs in process context from workqueue) ---
-static void rtl8811au_tx_worker(struct work_struct *work) {
-    struct rtl8811au_dev *priv = container_of(work, struct rtl8811au_dev, tx_worker_work);
-    struct sk_buff *skb;
-    unsigned long flags;
-    int ret;
-    unsigned char *tx_buffer; // DMA buffer for TX
-    dma_addr_t tx_dma;        // DMA address for TX buffer
-    struct urb *tx_urb;       // URB for TX
-    unsigned int len;
-    struct net_device_stats *stats = &priv->net_dev->stats;
+// --- Transmit Function (called by kernel) ---
+static netdev_tx_t rtl8811au_xmit(struct sk_buff *skb, struct net_device *dev) {
+    struct rtl8811au_dev *priv = netdev_priv(dev);
+    u64 t0 = rtl8811au_prof_start();
 
-    // Loop while there are packets and we are not already busy with a URB
-    while (true) {
-        // Try to grab a packet from the queue
+    // Don't transmit if device is not running or being removed
+    if (!netif_running(dev) || !priv->tx_thread) {
+        dev_kfree_skb_any(skb); // Free the skb
+        dev->stats.tx_dropped++;
+        goto out;
+    }
+
+    // Check if TX endpoint exists
+    if (priv->bulk_out_endpoint == 0) {
+         printk_once(KERN_ERR "%s: No bulk OUT endpoint for TX!\n", dev->name);
+         dev_kfree_skb_any(skb);
+         dev->stats.tx_dropped++;
+         goto out;
+    }
+
+    // Monitor interfaces are capture-only; frame injection is not supported
+    if (READ_ONCE(priv->monitor)) {
+        unsigned long flags;
+
+        dev_kfree_skb_any(skb);
+        spin_lock_irqsave(&priv->stats_lock, flags);
+        dev->stats.tx_dropped++;
+        priv->ext_stats.tx_drop_monitor++;
+        spin_unlock_irqrestore(&priv->stats_lock, flags);
+        goto out;
+    }
+
+    rtl8811au_tx_enqueue(priv, skb);
+
+out:
+    // Drops count too: every frame handed to us costs xmit time
+    rtl8811au_prof_end(priv, t0, RTL8811AU_PROF_XMIT, 1);
+    return NETDEV_TX_OK; // Packet accepted or dropped
+}
+
+// --- XDP Transmit ---
+// Feed an XDP frame into the regular TX pipeline. The frame memory becomes the skb head,
+// so nothing is copied; the XDP headroom covers the 802.11 encapsulation. Returns 0 once
+// the frame has been consumed, or an error if the caller still owns it.
+static int rtl8811au_xdp_xmit_frame(struct rtl8811au_dev *priv, struct xdp_frame *xdpf) {
+    struct sk_buff *skb;
+
+    skb = xdp_build_skb_from_frame(xdpf, priv->net_dev);
+    if (unlikely(!skb))
+        return -ENOMEM;
+    __skb_push(skb, ETH_HLEN); // Undo the eth_type_trans() done while building the skb
+    rtl8811au_tx_enqueue(priv, skb);
+    return 0;
+}
+
+// ndo_xdp_xmit: frames redirected to this device from other XDP programs
+static int rtl8811au_xdp_xmit(struct net_device *dev, int n, struct xdp_frame **frames, u32 flags) {
+    struct rtl8811au_dev *priv = netdev_priv(dev);
+    struct netdev_queue *txq = netdev_get_tx_queue(dev, 0);
+    unsigned long lock_flags;
+    int i, sent = 0;
+
+    if (unlikely(flags & ~XDP_XMIT_FLAGS_MASK))
+        return -EINVAL;
+    if (unlikely(!netif_running(dev) || !priv->tx_thread))
+        return -ENETDOWN;
+
+    __netif_tx_lock(txq, smp_processor_id());
+    for (i = 0; i < n; i++) {
+        if (netif_xmit_stopped(txq) || rtl8811au_xdp_xmit_frame(priv, frames[i]))
+            break; // The core frees whatever we did not consume
+        sent++;
+    }
+    __netif_tx_unlock(txq);
+
+    spin_lock_irqsave(&priv->stats_lock, lock_flags);
+    priv->ext_stats.tx_xdp_xmit += sent;
+    priv->ext_stats.tx_xdp_xmit_err += n - sent;
+    spin_unlock_irqrestore(&priv->stats_lock, lock_flags);
+    return sent;
+}
+
+// XDP_TX from the RX path: bounce the frame back out through our own TX queue
+static int rtl8811au_xdp_tx_buff(struct rtl8811au_dev *priv, struct xdp_buff *xdp) {
+    struct netdev_queue *txq = netdev_get_tx_queue(priv->net_dev, 0);
+    struct xdp_frame *xdpf;
+    int ret = -ENOSPC;
+
+    xdpf = xdp_convert_buff_to_frame(xdp);
+    if (unlikely(!xdpf))
+        return -EOVERFLOW;
+
+    __netif_tx_lock(txq, smp_processor_id());
+    if (!netif_xmit_stopped(txq))
+        ret = rtl8811au_xdp_xmit_frame(priv, xdpf);
+    __netif_tx_unlock(txq);
+    return ret;
+}
+
+// ndo_bpf: attach/detach the XDP program (called under RTNL)
+static int rtl8811au_bpf(struct net_device *dev, struct netdev_bpf *bpf) {
+    struct rtl8811au_dev *priv = netdev_priv(dev);
+    struct bpf_prog *old;
+
+    switch (bpf->command) {
+    case XDP_SETUP_PROG:
+        if (bpf->prog && dev->mtu > RTL8811AU_XDP_MAX_MTU) {
+            NL_SET_ERR_MSG_MOD(bpf->extack, "MTU too large for XDP");
+            return -EOPNOTSUPP;
+        }
+        old = rcu_replace_pointer(priv->xdp_prog, bpf->prog, lockdep_rtnl_is_held());
+        if (old)
+            bpf_prog_put(old);
+        printk(KERN_INFO "%s: XDP program %s\n", dev->name, bpf->prog ? "attached" : "detached");
+        return 0;
+    default:
+        return -EINVAL;
+    }
+}
+
+// --- TX Stall Watchdog ---
+// First good completion after a stall: record how long TX was impaired
+static void rtl8811au_tx_recovered(struct rtl8811au_dev *priv) {
+    unsigned long flags;
+    u64 us;
+
+    us = ktime_us_delta(ktime_get(), priv->tx_stall_start);
+    priv->tx_stall_start = 0;
+    priv->tx_stall_count = 0;
+
+    spin_lock_irqsave(&priv->stats_lock, flags);
+    priv->ext_stats.tx_stall_recovery_last_us = us;
+    priv->ext_stats.tx_stall_recovery_max_us = max(priv->ext_stats.tx_stall_recovery_max_us, us);
+    spin_unlock_irqrestore(&priv->stats_lock, flags);
+
+    printk(KERN_INFO "%s: TX recovered after %llu us\n", priv->net_dev->name, us);
+}
+
+// Runs on the TX thread, so it never races the TX worker between dequeue and submit.
+// Unlinks a TX URB that has been outstanding for RTL8811AU_TX_TIMEOUT; its completion
+// drops the skb, clears tx_busy and requeues the worker for whatever is still in
+// tx_queue, so the pipeline restarts with the queued frames intact.
+static void rtl8811au_tx_watchdog(struct kthread_work *work) {
+    struct rtl8811au_dev *priv = container_of(work, struct rtl8811au_dev, tx_watchdog_work.work);
+    struct net_device *dev = priv->net_dev;
+    unsigned long flags;
+    ktime_t submitted;
+    int ret;
+
+    if (!netif_running(dev) || !atomic_read(&priv->tx_busy))
+        return;
+
+    submitted = priv->tx_submit_time;
+    if (ktime_ms_delta(ktime_get(), submitted) < jiffies_to_msecs(RTL8811AU_TX_TIMEOUT)) {
+        // Woken early by ndo_tx_timeout while the current URB is still young
+        kthread_queue_delayed_work(priv->tx_thread, &priv->tx_watchdog_work, RTL8811AU_TX_TIMEOUT);
+        return;
+    }
+
+    priv->tx_stall_count++;
+    printk(KERN_WARNING "%s: TX URB stalled for %lld ms, unlinking (stall %u)\n",
+           dev->name, ktime_ms_delta(ktime_get(), submitted), priv->tx_stall_count);
+    spin_lock_irqsave(&priv->stats_lock, flags);
+    priv->ext_stats.tx_stalls++;
+    spin_unlock_irqrestore(&priv->stats_lock, flags);
+    if (!priv->tx_stall_start)
+        priv->tx_stall_start = submitted;
+
+    if (priv->tx_stall_count > RTL8811AU_TX_MAX_STALLS) {
+        printk(KERN_CRIT "%s: TX keeps stalling, resetting device\n", dev->name);
+        spin_lock_irqsave(&priv->stats_lock, flags);
+        priv->ext_stats.tx_stall_resets++;
+        spin_unlock_irqrestore(&priv->stats_lock, flags);
+        priv->tx_stall_count = 0;
+        usb_queue_reset_device(priv->usb_intf);
+        return;
+    }
+
+    // Completion runs with -ENOENT before this returns
+    usb_kill_anchored_urbs(&priv->tx_anchor);
+
+    // A bulk-out endpoint that NAKs forever often needs its halt/toggle state reset
+    ret = usb_clear_halt(priv->usb_dev, usb_sndbulkpipe(priv->usb_dev, priv->bulk_out_endpoint));
+    if (ret)
+        printk(KERN_ERR "%s: Failed to clear TX halt (error %d)\n", dev->name, ret);
+
+    // Nothing was in flight after all (busy flag leaked): restart by hand
+    if (atomic_xchg(&priv->tx_busy, 0)) {
+        priv->tx_skb = NULL;
+        rtl8811au_kick_tx(priv);
+    }
+    netif_trans_update(dev);
+    netif_wake_queue(dev);
+}
+
+// Called by the stack when the queue has been stopped for watchdog_timeo
+static void rtl8811au_tx_timeout(struct net_device *dev, unsigned int txqueue) {
+    struct rtl8811au_dev *priv = netdev_priv(dev);
+    unsigned long flags;
+
+    printk(KERN_WARNING "%s: TX timeout (queue %u, %u frames queued, busy %d)\n",
+           dev->name, txqueue, skb_queue_len(&priv->tx_queue), atomic_read(&priv->tx_busy));
+    spin_lock_irqsave(&priv->stats_lock, flags);
+    priv->ext_stats.tx_timeouts++;
+    spin_unlock_irqrestore(&priv->stats_lock, flags);
+
+    if (atomic_read(&priv->tx_busy))
+        kthread_mod_delayed_work(priv->tx_thread, &priv->tx_watchdog_work, 0);
+    else
+        rtl8811au_kick_tx(priv); // Idle with frames queued: kick the worker
+}
+
+// --- Wake Latency Accounting ---
+// A TX-triggered wake: from the worker finding the device asleep to it being usable
+static void rtl8811au_pm_account_wake(struct rtl8811au_dev *priv, ktime_t start) {
+    u64 us = ktime_us_delta(ktime_get(), start);
+    unsigned long flags;
+
+    spin_lock_irqsave(&priv->stats_lock, flags);
+    priv->ext_stats.pm_wake_last_us = us;
+    priv->ext_stats.pm_wake_max_us = max(priv->ext_stats.pm_wake_max_us, us);
+    spin_unlock_irqrestore(&priv->stats_lock, flags);
+}
+
+// --- TX Coalescing ---
+// tx-usecs after the first frame of a window: flush whatever has been queued
+static enum hrtimer_restart rtl8811au_tx_coal_timer(struct hrtimer *timer) {
+    struct rtl8811au_dev *priv = container_of(timer, struct rtl8811au_dev, tx_coal_timer);
+    unsigned long flags;
+
+    spin_lock_irqsave(&priv->tx_queue_lock, flags);
+    priv->tx_coal_due = true;
+    spin_unlock_irqrestore(&priv->tx_queue_lock, flags);
+
+    spin_lock_irqsave(&priv->stats_lock, flags);
+    priv->ext_stats.tx_coal_timeouts++;
+    spin_unlock_irqrestore(&priv->stats_lock, flags);
+
+    rtl8811au_kick_tx(priv);
+    return HRTIMER_NORESTART;
+}
+
+// Coalescing counterpart of the TX worker loop: pack the queued frames into tx_agg_buf
+// and send them as one bulk-out transfer. Same single-URB-in-flight rule, same PM and
+// watchdog handling; the completion handler kicks us again for anything left over.
+// The copied skbs stay on tx_agg_skbs until completion, which accounts and frees them.
+// Returns the number of frames submitted.
+static unsigned int rtl8811au_tx_flush_agg(struct rtl8811au_dev *priv) {
+    struct net_device_stats *stats = &priv->net_dev->stats;
+    struct rtl8811au_tx_desc *first;
+    unsigned int off = 0, frames = 0, dropped = 0;
+    struct sk_buff_head batch;
+    struct sk_buff *skb, *tmp;
+    struct urb *tx_urb;
+    unsigned long flags;
+    bool due;
+    u32 dw7;
+    int ret;
+
+    if (atomic_xchg(&priv->tx_busy, 1) != 0)
+        return 0; // Completion kicks the worker again
+
+    spin_lock_irqsave(&priv->tx_queue_lock, flags);
+    due = priv->tx_coal_due || skb_queue_len(&priv->tx_queue) >= priv->tx_coal_frames ||
+          priv->tx_coal_bytes + priv->tx_max_len > priv->tx_agg_size;
+    if (!due || skb_queue_empty(&priv->tx_queue)) {
+        // Window still open: the timer or the next enqueue kicks us
+        if (skb_queue_empty(&priv->tx_queue))
+            priv->tx_coal_due = false;
+        spin_unlock_irqrestore(&priv->tx_queue_lock, flags);
+        atomic_set(&priv->tx_busy, 0);
+        return 0;
+    }
+    spin_unlock_irqrestore(&priv->tx_queue_lock, flags);
+    hrtimer_try_to_cancel(&priv->tx_coal_timer);
+
+    tx_urb = usb_alloc_urb(0, GFP_KERNEL);
+    if (!tx_urb) {
+        atomic_set(&priv->tx_busy, 0);
+        return 0; // Frames stay queued for the next kick
+    }
+    ret = usb_autopm_get_interface(priv->usb_intf);
+    if (ret) {
+        usb_free_urb(tx_urb);
+        atomic_set(&priv->tx_busy, 0);
+        return 0; // Resume kicks the worker again
+    }
+
+    // Take as many frames as fit, each descriptor 8-byte aligned; copy outside the lock
+    __skb_queue_head_init(&batch);
+    spin_lock_irqsave(&priv->tx_queue_lock, flags);
+    while (frames < priv->tx_coal_frames && (skb = skb_peek(&priv->tx_queue))) {
+        // An oversized frame at the head is taken alone so it can be dropped below
+        if (frames && ALIGN(off, RTL8811AU_TX_AGG_ALIGN) + skb->len > priv->tx_agg_size)
+            break;
+        skb_unlink(skb, &priv->tx_queue);
+        __skb_queue_tail(&batch, skb);
+        off = ALIGN(off, RTL8811AU_TX_AGG_ALIGN) + skb->len;
+        frames++;
+    }
+    priv->tx_coal_bytes = 0;
+    // Frames left behind have already waited a full window
+    priv->tx_coal_due = !skb_queue_empty(&priv->tx_queue);
+    spin_unlock_irqrestore(&priv->tx_queue_lock, flags);
+
+    off = 0;
+    frames = 0;
+    skb_queue_walk_safe(&batch, skb, tmp) {
+        if (unlikely(skb->len > priv->tx_max_len)) {
+            __skb_unlink(skb, &batch);
+            dropped++;
+            dev_kfree_skb_any(skb);
+            continue;
+        }
+        off = ALIGN(off, RTL8811AU_TX_AGG_ALIGN);
+        memcpy(priv->tx_agg_buf + off, skb->data, skb->len);
+        off += skb->len;
+        frames++;
+    }
+    if (dropped) {
+        spin_lock_irqsave(&priv->stats_lock, flags);
+        stats->tx_dropped += dropped;
+        spin_unlock_irqrestore(&priv->stats_lock, flags);
+    }
+
+    if (!frames) {
+        usb_autopm_put_interface(priv->usb_intf);
+        usb_free_urb(tx_urb);
+        atomic_set(&priv->tx_busy, 0);
+        return 0;
+    }
+
+    // The first descriptor announces how many frames the transfer holds
+    first = (struct rtl8811au_tx_desc *)priv->tx_agg_buf;
+    dw7 = le32_to_cpu(first->dw7) & ~TX_DESC_DW7_USB_AGG_NUM;
+    first->dw7 = cpu_to_le32(dw7 | FIELD_PREP(TX_DESC_DW7_USB_AGG_NUM, frames));
+    rtl8811au_tx_desc_checksum(first);
+
+    priv->tx_skb = NULL; // The frames are on tx_agg_skbs instead
+    skb_queue_splice_tail_init(&batch, &priv->tx_agg_skbs);
+    usb_fill_bulk_urb(tx_urb, priv->usb_dev,
+                      usb_sndbulkpipe(priv->usb_dev, priv->bulk_out_endpoint),
+                      priv->tx_agg_buf, off, rtl8811au_tx_complete, priv);
+    tx_urb->transfer_flags |= URB_ZERO_PACKET;
+
+    priv->tx_submit_time = ktime_get();
+    usb_anchor_urb(tx_urb, &priv->tx_anchor);
+    ret = usb_submit_urb(tx_urb, GFP_KERNEL);
+    if (ret) {
+        usb_unanchor_urb(tx_urb);
+        dev_err(&priv->usb_intf->dev, "%s: Failed to submit aggregated TX URB (error %d)\n", priv->net_dev->name, ret);
+        __skb_queue_purge(&priv->tx_agg_skbs);
+        spin_lock_irqsave(&priv->stats_lock, flags);
+        stats->tx_errors++;
+        stats->tx_dropped += frames;
+        spin_unlock_irqrestore(&priv->stats_lock, flags);
+        usb_free_urb(tx_urb);
+        usb_autopm_put_interface(priv->usb_intf);
+        atomic_set(&priv->tx_busy, 0);
+        return 0;
+    }
+    kthread_mod_delayed_work(priv->tx_thread, &priv->tx_watchdog_work, RTL8811AU_TX_TIMEOUT);
+
+    spin_lock_irqsave(&priv->stats_lock, flags);
+    priv->ext_stats.tx_agg_urbs++;
+    priv->ext_stats.tx_agg_frames += frames;
+    spin_unlock_irqrestore(&priv->stats_lock, flags);
+    return frames;
+}
+
+// --- TX Worker Function (runs in process context from workqueue) ---
+static void rtl8811au_tx_worker(struct kthread_work *work) {
+    struct rtl8811au_dev *priv = container_of(work, struct rtl8811au_dev, tx_worker_work);
+    struct sk_buff *skb;
+    unsigned long flags;
+    int ret;
+    struct urb *tx_urb;       // URB for TX
+    unsigned int len;
+    struct net_device_stats *stats = &priv->net_dev->stats;
+    unsigned int sent = 0;
+    u64 t0;
+
+    // Down or mid-reset: frames wait in tx_queue until open/post_reset kicks us again
+    if (!netif_running(priv->net_dev) || !netif_device_present(priv->net_dev))
+        return;
+
+    t0 = rtl8811au_prof_start();
+    if (READ_ONCE(priv->tx_coal_usecs)) {
+        sent = rtl8811au_tx_flush_agg(priv);
+        goto out;
+    }
+
+    // Loop while there are packets and we are not already busy with a URB
+    while (true) {
+        // Try to grab a packet from the queue
         spin_lock_irqsave(&priv->tx_queue_lock, flags);
         skb = skb_dequeue(&priv->tx_queue);
         if (!skb) {
@@ -287,8 +1820,8 @@ static void rtl8811au_tx_worker(struct work_struct *work) {
 
         len = skb->len;
         // Sanity check packet length (should ideally be handled by higher layers)
-        if (len > MAX_PACKET_SIZE) {
-            dev_err(&priv->usb_intf->dev, "%s: Oversized packet (%d > %d)\n", priv->net_dev->name, len, MAX_PACKET_SIZE);
+        if (len > priv->tx_max_len) {
+            dev_err(&priv->usb_intf->dev, "%s: Oversized packet (%d > %d)\n", priv->net_dev->name, len, priv->tx_max_len);
             spin_lock_irqsave(&priv->stats_lock, flags);
             stats->tx_dropped++;
             spin_unlock_irqrestore(&priv->stats_lock, flags);
@@ -310,165 +1843,831 @@ static void rtl8811au_tx_worker(struct work_struct *work) {
             continue; // Try next packet
         }
 
-        // Allocate DMA buffer for this TX operation
-        // Note: Allocating per packet might be inefficient for high rates.
-        tx_buffer = usb_alloc_coherent(priv->usb_dev, len, GFP_KERNEL, &tx_dma);
-        if (!tx_buffer) {
-            dev_err(&priv->usb_intf->dev, "%s: Failed to allocate TX buffer (len %d)\n", priv->net_dev->name, len);
+        // Frames queued while suspended wait here for the device to wake up. The
+        // reference is dropped by the completion handler.
+        if (unlikely(READ_ONCE(priv->suspended))) {
+            ktime_t wake_start = ktime_get();
+
+            ret = usb_autopm_get_interface(priv->usb_intf);
+            if (!ret)
+                rtl8811au_pm_account_wake(priv, wake_start);
+        } else {
+            ret = usb_autopm_get_interface(priv->usb_intf);
+        }
+        if (ret) {
+            // System sleep in progress: keep the frame, resume kicks the worker again
+            usb_free_urb(tx_urb);
+            skb_queue_head(&priv->tx_queue, skb);
+            atomic_set(&priv->tx_busy, 0);
+            break;
+        }
+
+        // The skb already holds descriptor + 802.11 frame (see rtl8811au_tx_encap),
+        // so it is handed to the HCD directly: no bounce buffer, no copy.
+        priv->tx_skb = skb;
+
+        // Fill the TX URB
+        usb_fill_bulk_urb(tx_urb, priv->usb_dev,
+                          usb_sndbulkpipe(priv->usb_dev, priv->bulk_out_endpoint),
+                          skb->data, len,
+                          rtl8811au_tx_complete,
+                          priv); // Pass priv structure as context (FIXED)
+        tx_urb->transfer_flags |= URB_ZERO_PACKET; // Terminate transfers that end on a packet boundary
+
+        // Submit the TX URB, anchored so the watchdog can find it
+        priv->tx_submit_time = ktime_get();
+        usb_anchor_urb(tx_urb, &priv->tx_anchor);
+        ret = usb_submit_urb(tx_urb, GFP_KERNEL);
+        if (ret) {
+            usb_unanchor_urb(tx_urb);
+            dev_err(&priv->usb_intf->dev, "%s: Failed to submit TX URB (error %d)\n", priv->net_dev->name, ret);
             spin_lock_irqsave(&priv->stats_lock, flags);
-            stats->tx_dropped++;
+            stats->tx_errors++;
+            stats->tx_dropped++; // Also count as dropped if submit fails
             spin_unlock_irqrestore(&priv->stats_lock, flags);
-            dev_kfree_skb_any(skb);
-            usb_free_urb(tx_urb);
+
+            priv->tx_skb = NULL; // Clear skb pointer
+            dev_kfree_skb_any(skb); // Free skb
+            usb_free_urb(tx_urb); // Free URB
+            usb_autopm_put_interface(priv->usb_intf);
             atomic_set(&priv->tx_busy, 0); // Clear busy flag
             continue; // Try next packet
         }
 
-        // Copy packet data to DMA buffer
-        memcpy(tx_buffer, skb->data, len);
+        // Arm the stall watchdog; the completion handler disarms it
+        kthread_mod_delayed_work(priv->tx_thread, &priv->tx_watchdog_work, RTL8811AU_TX_TIMEOUT);
+
+        // Packets and bytes are counted by the completion handler
+        sent++;
+
+        // URB is in flight, the worker must wait for completion before sending next packet.
+        // Break out of the loop. The completion handler will clear tx_busy
+        // and potentially re-queue the worker if needed.
+        break;
+
+    } // end while(true)
+
+    // If we broke out of the loop because the queue was empty,
+    // ensure the network queue is awake (if it was stopped)
+    spin_lock_irqsave(&priv->tx_queue_lock, flags);
+    if (skb_queue_len(&priv->tx_queue) < RTL8811AU_TX_QUEUE_WAKE) {
+       if (netif_queue_stopped(priv->net_dev) && atomic_read(&priv->tx_busy) == 0) {
+           netif_wake_queue(priv->net_dev);
+           printk(KERN_DEBUG "%s: TX queue woken up by worker\n", priv->net_dev->name);
+       }
+    }
+    spin_unlock_irqrestore(&priv->tx_queue_lock, flags);
+out:
+    rtl8811au_prof_end(priv, t0, RTL8811AU_PROF_TX_WORKER, sent);
+}
+
+
+// --- TX Completion Handler (runs in atomic context) ---
+static void rtl8811au_tx_complete(struct urb *urb) {
+    // Get private data structure from URB context (FIXED)
+    struct rtl8811au_dev *priv = urb->context;
+    struct sk_buff *skb; // SKB pointer will be retrieved from priv
+    struct net_device_stats *stats;
+    unsigned int frames = 0, bytes = 0;
+    unsigned long flags;
+    int status = urb->status;
+    bool queue_was_stopped;
+    bool work_queued = false;
+    u64 t0 = rtl8811au_prof_start();
+
+    // Basic sanity checks
+    if (!priv || !priv->net_dev) {
+        printk(KERN_ERR "rtl8811au_wifi: Invalid context or net_dev in TX complete\n");
+        // The transfer buffer belongs to the skb, which is unreachable without priv
+        usb_free_urb(urb);
+        return;
+    }
+
+    stats = &priv->net_dev->stats;
+    skb = priv->tx_skb; // Retrieve SKB pointer (FIXED)
+
+    // The URB is back, so it did not stall. The watchdog stays armed (there is no
+    // non-blocking kthread cancel); a stale run finds tx_busy clear, or a younger URB,
+    // and does nothing. Unlinks by the watchdog come through here too.
+    if (status == 0) {
+        netif_trans_update(priv->net_dev); // Progress, keeps the stack's watchdog quiet
+        if (unlikely(priv->tx_stall_start))
+            rtl8811au_tx_recovered(priv);
+    }
+
+    if (!skb && urb->transfer_buffer != priv->tx_agg_buf) {
+       printk(KERN_ERR "%s: TX complete but skb pointer was NULL!\n", priv->net_dev->name);
+       // Don't try to free skb, but do free USB resources
+    }
+
+    // Free the SKB (if we have a pointer to it), or the frames of an aggregate; they
+    // count as sent only now that the transfer is done
+    if (skb) {
+        priv->tx_skb = NULL; // Clear pointer before freeing
+        frames = 1;
+        bytes = skb->len;
+        if (status == 0)
+            dev_consume_skb_any(skb);
+        else
+            dev_kfree_skb_any(skb);
+    }
+    while ((skb = __skb_dequeue(&priv->tx_agg_skbs))) {
+        frames++;
+        bytes += skb->len;
+        if (status == 0)
+            dev_consume_skb_any(skb);
+        else
+            dev_kfree_skb_any(skb);
+    }
+
+    // Check URB status
+    spin_lock_irqsave(&priv->stats_lock, flags);
+    if (status == 0) {
+        stats->tx_packets += frames;
+        stats->tx_bytes += bytes;
+    } else {
+        // Submit succeeded but the transfer failed or was unlinked: the frames are lost
+        stats->tx_errors++;
+        stats->tx_dropped += frames;
+    }
+    spin_unlock_irqrestore(&priv->stats_lock, flags);
+    if (status != 0)
+        printk(KERN_ERR "%s: TX URB failed (status %d)\n", priv->net_dev->name, status);
+
+    // Free the URB itself
+    usb_free_urb(urb);
+    usb_mark_last_busy(priv->usb_dev);
+    usb_autopm_put_interface_async(priv->usb_intf); // Taken by the TX worker
+
+    // --- TX is no longer busy ---
+    // Clear the busy flag *before* checking queue, ensures worker won't race
+    atomic_set(&priv->tx_busy, 0);
+
+    // Check if more packets are waiting and schedule worker if needed
+    spin_lock_irqsave(&priv->tx_queue_lock, flags);
+    queue_was_stopped = netif_queue_stopped(priv->net_dev);
+    if (skb_queue_len(&priv->tx_queue) > 0) {
+        // More work to do, queue the worker again
+        rtl8811au_kick_tx(priv);
+        work_queued = true; // Worker will handle waking queue if necessary later
+    } else {
+        // Queue is empty, wake it up if it was stopped
+        if (queue_was_stopped) {
+             netif_wake_queue(priv->net_dev);
+             printk(KERN_DEBUG "%s: TX queue woken up by completion\n", priv->net_dev->name);
+        }
+    }
+    spin_unlock_irqrestore(&priv->tx_queue_lock, flags);
+
+    rtl8811au_prof_end(priv, t0, RTL8811AU_PROF_TX_COMPLETE, 1);
+}
+
+// --- RX Descriptor Parser ---
+// Decodes the fixed-layout descriptor with one little-endian load per dword. Returns
+// -EMSGSIZE if the descriptor or the frame it announces runs past the end of the buffer.
+static inline int rtl8811au_parse_rx_desc(const u8 *buf, unsigned int avail,
+                                          struct rtl8811au_rx_info *info) {
+    const struct rtl8811au_rx_desc *desc = (const struct rtl8811au_rx_desc *)buf;
+    const struct rtl8811au_rx_phy_status *phy;
+    unsigned int drvinfo_len;
+    u32 dw0, dw2, dw3;
+
+    if (avail < RTL8811AU_RX_DESC_SIZE)
+        return -EMSGSIZE;
+
+    dw0 = le32_to_cpu(desc->dw0);
+    dw2 = le32_to_cpu(desc->dw2);
+    dw3 = le32_to_cpu(desc->dw3);
+
+    drvinfo_len = FIELD_GET(RX_DESC_DW0_DRVINFO_SZ, dw0) * RTL8811AU_RX_DRVINFO_UNIT;
+    info->pkt_len = FIELD_GET(RX_DESC_DW0_PKT_LEN, dw0);
+    info->crc_err = dw0 & RX_DESC_DW0_CRC32;
+    info->icv_err = dw0 & RX_DESC_DW0_ICV_ERR;
+    info->has_phy_status = (dw0 & RX_DESC_DW0_PHYST) && drvinfo_len >= sizeof(*phy);
+    info->is_c2h = dw2 & RX_DESC_DW2_RPT_SEL;
+    info->rate = FIELD_GET(RX_DESC_DW3_RX_RATE, dw3);
+    info->security = FIELD_GET(RX_DESC_DW0_SECURITY, dw0);
+    info->tsfl = le32_to_cpu(desc->dw5);
+    info->frame_offset = RTL8811AU_RX_DESC_SIZE + drvinfo_len + FIELD_GET(RX_DESC_DW0_SHIFT, dw0);
+    info->total_len = ALIGN(info->frame_offset + info->pkt_len, RTL8811AU_RX_AGG_ALIGN);
+
+    if (info->frame_offset + info->pkt_len > avail)
+        return -EMSGSIZE;
+
+    if (info->has_phy_status) {
+        phy = (const struct rtl8811au_rx_phy_status *)(buf + RTL8811AU_RX_DESC_SIZE);
+        info->pwdb = phy->pwdb_all;
+        info->rssi = (s8)((phy->pwdb_all >> 1) - 110);
+        info->channel = FIELD_GET(RX_PHY_CHL_NUM, le16_to_cpu(phy->chl_info));
+    }
+    return 0;
+}
+
+// Translate a hardware rate index into cfg80211 rate_info
+static void rtl8811au_rate_to_rate_info(u8 hw_rate, struct rate_info *ri) {
+    static const u16 legacy_rates[] = { 10, 20, 55, 110, 60, 90, 120, 180, 240, 360, 480, 540 };
+
+    memset(ri, 0, sizeof(*ri));
+    ri->bw = RATE_INFO_BW_20; // Bandwidth is not reported in the RX descriptor
+
+    if (hw_rate <= RTL8811AU_DESC_RATE_OFDM_MAX) {
+        ri->legacy = legacy_rates[hw_rate];
+    } else if (hw_rate <= RTL8811AU_DESC_RATE_HT_MAX) {
+        ri->flags = RATE_INFO_FLAGS_MCS;
+        ri->mcs = hw_rate - (RTL8811AU_DESC_RATE_OFDM_MAX + 1);
+    } else if (hw_rate <= RTL8811AU_DESC_RATE_VHT_MAX) {
+        hw_rate -= RTL8811AU_DESC_RATE_HT_MAX + 1;
+        ri->flags = RATE_INFO_FLAGS_VHT_MCS;
+        ri->nss = hw_rate / 10 + 1;
+        ri->mcs = hw_rate % 10;
+    }
+}
+
+// --- 802.11 -> 802.3 Decapsulation ---
+// IV and ICV/MIC lengths left in hardware-decrypted frames, indexed by RTL8811AU_SEC_*
+static const u8 rtl8811au_sec_iv_len[8] = {
+    [RTL8811AU_SEC_WEP40] = 4, [RTL8811AU_SEC_TKIP] = 8,
+    [RTL8811AU_SEC_AES] = 8, [RTL8811AU_SEC_WEP104] = 4,
+};
+static const u8 rtl8811au_sec_icv_len[8] = {
+    [RTL8811AU_SEC_WEP40] = 4, [RTL8811AU_SEC_TKIP] = 4,
+    [RTL8811AU_SEC_AES] = 8, [RTL8811AU_SEC_WEP104] = 4,
+};
+
+// Derive the Ethernet header for an 802.11 data frame (FCS already excluded from len)
+// and locate its payload, without touching the frame. Returns the payload offset and
+// length, -EPROTO for frames that carry no data, or -EINVAL for truncated frames.
+static int rtl8811au_rx_decap(const u8 *frame, unsigned int len, const struct rtl8811au_rx_info *info,
+                              struct ethhdr *eth, unsigned int *payload_len) {
+    const struct ieee80211_hdr *hdr = (const struct ieee80211_hdr *)frame;
+    unsigned int hdrlen, trailer = 0;
+    const u8 *payload;
+    __be16 ethertype;
+
+    if (len < sizeof(struct ieee80211_hdr_3addr))
+        return -EINVAL;
+    if (!ieee80211_is_data_present(hdr->frame_control))
+        return -EPROTO;
+
+    hdrlen = ieee80211_hdrlen(hdr->frame_control);
+    if (ieee80211_has_protected(hdr->frame_control)) {
+        hdrlen += rtl8811au_sec_iv_len[info->security & 7];
+        trailer = rtl8811au_sec_icv_len[info->security & 7];
+    }
+    if (len < hdrlen + trailer)
+        return -EINVAL;
+    len -= trailer;
+
+    memcpy(eth->h_dest, ieee80211_get_DA((struct ieee80211_hdr *)hdr), ETH_ALEN);
+    memcpy(eth->h_source, ieee80211_get_SA((struct ieee80211_hdr *)hdr), ETH_ALEN);
+    payload = frame + hdrlen;
+
+    // Strip RFC 1042 / bridge-tunnel SNAP headers the same way cfg80211 does
+    if (len >= hdrlen + sizeof(rfc1042_header) + 2) {
+        memcpy(&ethertype, payload + sizeof(rfc1042_header), 2);
+        if ((!memcmp(payload, rfc1042_header, sizeof(rfc1042_header)) &&
+             ethertype != htons(ETH_P_AARP) && ethertype != htons(ETH_P_IPX)) ||
+            !memcmp(payload, bridge_tunnel_header, sizeof(bridge_tunnel_header))) {
+            eth->h_proto = ethertype;
+            hdrlen += sizeof(rfc1042_header) + 2;
+            *payload_len = len - hdrlen;
+            return hdrlen;
+        }
+    }
+
+    // No SNAP: deliver as an 802.3 length-field frame
+    eth->h_proto = htons(len - hdrlen);
+    *payload_len = len - hdrlen;
+    return hdrlen;
+}
+
+// --- RX Frame Delivery ---
+// Copy one decapsulated frame into a page fragment, run the attached XDP program on it
+// and, for XDP_PASS (or no program), build the skb around the same memory.
+static void rtl8811au_rx_frame(struct rtl8811au_dev *priv, struct bpf_prog *prog,
+                               const struct ethhdr *eth, const u8 *payload, unsigned int payload_len,
+                               struct rtl8811au_rx_batch *batch) {
+    unsigned int len = ETH_HLEN + payload_len;
+    unsigned int truesize = RTL8811AU_RX_TRUESIZE(len);
+    unsigned int metasize;
+    struct sk_buff *skb;
+    struct xdp_buff xdp;
+    u32 act = XDP_PASS;
+    u8 *data;
+
+    // Jumbo frames do not fit a page fragment. XDP is never attached at such MTUs
+    // (see rtl8811au_bpf and rtl8811au_change_mtu), so a plain skb will do.
+    if (unlikely(truesize > PAGE_SIZE)) {
+        skb = napi_alloc_skb(&priv->napi, len);
+        if (unlikely(!skb)) {
+            batch->dropped++;
+            return;
+        }
+        skb_put_data(skb, eth, ETH_HLEN);
+        skb_put_data(skb, payload, payload_len);
+        goto deliver;
+    }
+
+    data = napi_alloc_frag(truesize);
+    if (unlikely(!data)) {
+        batch->dropped++;
+        return;
+    }
+    // The only copy out of the bulk-in buffer: Ethernet header, then payload
+    memcpy(data + RTL8811AU_RX_HEADROOM, eth, ETH_HLEN);
+    memcpy(data + RTL8811AU_RX_HEADROOM + ETH_HLEN, payload, payload_len);
+
+    xdp_init_buff(&xdp, truesize, &priv->xdp_rxq);
+    xdp_prepare_buff(&xdp, data, RTL8811AU_RX_HEADROOM, len, true);
+
+    if (prog) {
+        act = bpf_prog_run_xdp(prog, &xdp);
+        switch (act) {
+        case XDP_PASS:
+            break;
+        case XDP_TX:
+            if (rtl8811au_xdp_tx_buff(priv, &xdp))
+                goto xdp_err;
+            batch->xdp_tx++;
+            return;
+        case XDP_REDIRECT:
+            if (xdp_do_redirect(priv->net_dev, &xdp, prog))
+                goto xdp_err;
+            priv->xdp_flush = true;
+            batch->xdp_redirect++;
+            return;
+        case XDP_DROP:
+            batch->xdp_drop++;
+            skb_free_frag(data);
+            return;
+        default:
+            bpf_warn_invalid_xdp_action(priv->net_dev, prog, act);
+            fallthrough;
+        case XDP_ABORTED:
+xdp_err:
+            trace_xdp_exception(priv->net_dev, prog, act);
+            batch->xdp_aborted++;
+            skb_free_frag(data);
+            return;
+        }
+    }
+
+    skb = napi_build_skb(data, truesize);
+    if (unlikely(!skb)) {
+        skb_free_frag(data);
+        batch->dropped++;
+        return;
+    }
+    // The program may have moved the packet boundaries or added metadata
+    skb_reserve(skb, xdp.data - xdp.data_hard_start);
+    skb_put(skb, xdp.data_end - xdp.data);
+    metasize = xdp.data - xdp.data_meta;
+    if (metasize)
+        skb_metadata_set(skb, metasize);
+
+deliver:
+    // Set up SKB metadata
+    skb->protocol = eth_type_trans(skb, priv->net_dev);
+    skb->ip_summed = CHECKSUM_NONE; // Assume no checksum offload
+
+    batch->packets++;
+    batch->bytes += skb->len;
+    napi_gro_receive(&priv->napi, skb); // Send it up the network stack
+}
+
+// --- Monitor Mode Delivery ---
+// Fill the radiotap header that ends at `end` from the decoded descriptor; returns its length.
+// Built front to back in a local buffer, since the length is only known at the end.
+static unsigned int rtl8811au_fill_radiotap(u8 *end, const struct rtl8811au_rx_info *info) {
+    u8 buf[RTL8811AU_RADIOTAP_MAX_LEN] __aligned(8) = {};
+    struct ieee80211_radiotap_header *rt = (struct ieee80211_radiotap_header *)buf;
+    unsigned int len = sizeof(*rt);
+    struct rate_info ri;
+    u32 present;
+    __le16 chan[2];
+    __le64 tsft;
+
+    rtl8811au_rate_to_rate_info(info->rate, &ri);
+    present = BIT(IEEE80211_RADIOTAP_TSFT) | BIT(IEEE80211_RADIOTAP_FLAGS);
+
+    tsft = cpu_to_le64(info->tsfl);
+    memcpy(buf + len, &tsft, sizeof(tsft)); // Offset 8, already aligned
+    len += sizeof(tsft);
+    // Frames are delivered with their FCS; monitor mode also captures ones that fail it
+    buf[len++] = IEEE80211_RADIOTAP_F_FCS | (info->crc_err ? IEEE80211_RADIOTAP_F_BADFCS : 0);
+
+    if (!(ri.flags & (RATE_INFO_FLAGS_MCS | RATE_INFO_FLAGS_VHT_MCS))) {
+        present |= BIT(IEEE80211_RADIOTAP_RATE);
+        buf[len++] = ri.legacy / 5; // 500 kbps units
+    }
+
+    // The channel comes from the PHY status; without it the field is left out
+    if (info->has_phy_status && info->channel) {
+        enum nl80211_band band = info->channel > 14 ? NL80211_BAND_5GHZ : NL80211_BAND_2GHZ;
+
+        present |= BIT(IEEE80211_RADIOTAP_CHANNEL);
+        chan[0] = cpu_to_le16(ieee80211_channel_to_frequency(info->channel, band));
+        chan[1] = cpu_to_le16(band == NL80211_BAND_5GHZ ? IEEE80211_CHAN_5GHZ : IEEE80211_CHAN_2GHZ);
+        len = ALIGN(len, 2);
+        memcpy(buf + len, chan, sizeof(chan));
+        len += sizeof(chan);
+    }
+
+    if (info->has_phy_status) {
+        present |= BIT(IEEE80211_RADIOTAP_DBM_ANTSIGNAL);
+        buf[len++] = (u8)info->rssi;
+    }
+
+    if (ri.flags & RATE_INFO_FLAGS_MCS) {
+        present |= BIT(IEEE80211_RADIOTAP_MCS);
+        buf[len] = IEEE80211_RADIOTAP_MCS_HAVE_MCS; // known
+        buf[len + 2] = ri.mcs;
+        len += 3;
+    } else if (ri.flags & RATE_INFO_FLAGS_VHT_MCS) {
+        present |= BIT(IEEE80211_RADIOTAP_VHT);
+        len = ALIGN(len, 2);
+        // known (le16) stays 0: bandwidth, GI and coding are not reported per frame
+        buf[len + 4] = (ri.mcs << 4) | ri.nss; // mcs_nss[0]
+        len += 12;
+    }
+
+    rt->it_len = cpu_to_le16(len);
+    rt->it_present = cpu_to_le32(present);
+    memcpy(end - len, buf, len);
+    return len;
+}
+
+// Copy the raw 802.11 frame (with FCS) into a page fragment and prepend radiotap in the
+// headroom, so capture costs exactly one copy out of the bulk-in buffer
+static void rtl8811au_rx_monitor(struct rtl8811au_dev *priv, const struct rtl8811au_rx_info *info,
+                                 const u8 *frame, struct rtl8811au_rx_batch *batch) {
+    unsigned int truesize = RTL8811AU_RX_TRUESIZE(info->pkt_len);
+    unsigned int rt_len;
+    struct sk_buff *skb;
+    u8 *data;
+
+    // Frames too long for a page fragment (A-MSDUs at large MTUs) get a plain skb with
+    // room for the radiotap header in front, as rtl8811au_rx_frame does
+    if (unlikely(truesize > PAGE_SIZE)) {
+        skb = napi_alloc_skb(&priv->napi, RTL8811AU_RADIOTAP_MAX_LEN + info->pkt_len);
+        if (unlikely(!skb)) {
+            batch->dropped++;
+            return;
+        }
+        skb_reserve(skb, RTL8811AU_RADIOTAP_MAX_LEN);
+        skb_put_data(skb, frame, info->pkt_len);
+        rt_len = rtl8811au_fill_radiotap(skb->data, info);
+        skb_push(skb, rt_len);
+        goto deliver;
+    }
+
+    data = napi_alloc_frag(truesize);
+    if (unlikely(!data)) {
+        batch->dropped++;
+        return;
+    }
+    memcpy(data + RTL8811AU_RX_HEADROOM, frame, info->pkt_len);
+    rt_len = rtl8811au_fill_radiotap(data + RTL8811AU_RX_HEADROOM, info);
+
+    skb = napi_build_skb(data, truesize);
+    if (unlikely(!skb)) {
+        skb_free_frag(data);
+        batch->dropped++;
+        return;
+    }
+    skb_reserve(skb, RTL8811AU_RX_HEADROOM - rt_len);
+    skb_put(skb, rt_len + info->pkt_len);
+
+deliver:
+    skb_reset_mac_header(skb);
+    skb->dev = priv->net_dev;
+    skb->ip_summed = CHECKSUM_UNNECESSARY;
+    skb->pkt_type = PACKET_OTHERHOST;
+    skb->protocol = htons(ETH_P_802_2);
+
+    batch->monitor++;
+    batch->packets++;
+    batch->bytes += skb->len;
+    netif_receive_skb(skb);
+}
+
+// --- RX Frame Processing ---
+// Walks every frame packed into one bulk-in transfer. Frames with CRC/ICV errors and
+// firmware reports are dropped before any memory is allocated, except that monitor mode
+// captures errored frames (flagged in radiotap) as the RCR asks for. Counters are accumulated
+// locally and applied under stats_lock once per transfer. Returns the number of frames.
+static int rtl8811au_rx_process(struct rtl8811au_dev *priv, const u8 *buf, unsigned int len) {
+    struct net_device_stats *stats = &priv->net_dev->stats;
+    struct rtl8811au_ext_stats *ext = &priv->ext_stats;
+    struct rtl8811au_rx_batch batch = {};
+    struct rtl8811au_rx_info info;
+    unsigned int offset = 0;
+    unsigned int payload_len;
+    struct bpf_prog *prog;
+    struct ethhdr eth;
+    const u8 *frame;
+    int payload_off;
+    unsigned long flags;
+    bool monitor = READ_ONCE(priv->monitor);
+
+    rcu_read_lock();
+    prog = rcu_dereference(priv->xdp_prog);
+
+    while (offset < len) {
+        if (rtl8811au_parse_rx_desc(buf + offset, len - offset, &info)) {
+            batch.desc_err++;
+            break; // Rest of the buffer cannot be trusted
+        }
+        batch.frames++;
+
+        if (info.is_c2h) {
+            batch.c2h++;
+            goto next;
+        }
+        if (info.crc_err || info.icv_err) {
+            if (info.crc_err)
+                batch.crc_err++;
+            else
+                batch.icv_err++;
+            // Counted as errors either way; no RSSI/rate from a frame that failed its check
+            if (monitor && info.pkt_len > FCS_LEN)
+                rtl8811au_rx_monitor(priv, &info, buf + offset + info.frame_offset, &batch);
+            goto next;
+        }
+        if (info.pkt_len <= FCS_LEN) {
+            batch.desc_err++;
+            goto next;
+        }
+
+        if (info.has_phy_status) {
+            batch.have_phy = true;
+            batch.last_pwdb = info.pwdb;
+            WRITE_ONCE(priv->last_rssi, info.rssi);
+        }
+        batch.last_rate = info.rate;
 
-        // Store skb pointer in private struct (FIXED: context handling)
-        priv->tx_skb = skb;
+        if (monitor) {
+            rtl8811au_rx_monitor(priv, &info, buf + offset + info.frame_offset, &batch);
+            goto next;
+        }
 
-        // Fill the TX URB
-        usb_fill_bulk_urb(tx_urb, priv->usb_dev,
-                          usb_sndbulkpipe(priv->usb_dev, priv->bulk_out_endpoint),
-                          tx_buffer, len,
-                          rtl8811au_tx_complete,
-                          priv); // Pass priv structure as context (FIXED)
-        tx_urb->transfer_flags |= URB_NO_TRANSFER_DMA_MAP; // Use pre-allocated coherent buffer
-        tx_urb->transfer_dma = tx_dma;
+        // Work out the Ethernet header before allocating anything
+        frame = buf + offset + info.frame_offset;
+        payload_off = rtl8811au_rx_decap(frame, info.pkt_len - FCS_LEN, &info, &eth, &payload_len);
+        if (payload_off < 0) {
+            if (payload_off == -EPROTO)
+                batch.non_data++;
+            else
+                batch.decap_err++;
+            goto next;
+        }
 
-        // Submit the TX URB
-        ret = usb_submit_urb(tx_urb, GFP_KERNEL);
-        if (ret) {
-            dev_err(&priv->usb_intf->dev, "%s: Failed to submit TX URB (error %d)\n", priv->net_dev->name, ret);
-            spin_lock_irqsave(&priv->stats_lock, flags);
-            stats->tx_errors++;
-            stats->tx_dropped++; // Also count as dropped if submit fails
-            spin_unlock_irqrestore(&priv->stats_lock, flags);
+        rtl8811au_rx_frame(priv, prog, &eth, frame + payload_off, payload_len, &batch);
+next:
+        offset += info.total_len;
+    }
+    rcu_read_unlock();
+
+    if (batch.packets)
+        WRITE_ONCE(priv->last_rate, batch.last_rate);
+
+    spin_lock_irqsave(&priv->stats_lock, flags);
+    stats->rx_packets += batch.packets;
+    stats->rx_bytes += batch.bytes;
+    stats->rx_dropped += batch.dropped + batch.xdp_drop + batch.xdp_aborted;
+    stats->rx_crc_errors += batch.crc_err;
+    stats->rx_frame_errors += batch.desc_err;
+    stats->rx_length_errors += batch.decap_err;
+    stats->rx_errors += batch.crc_err + batch.icv_err + batch.desc_err + batch.decap_err;
+    ext->rx_frames += batch.frames;
+    ext->rx_crc_err += batch.crc_err;
+    ext->rx_icv_err += batch.icv_err;
+    ext->rx_desc_err += batch.desc_err;
+    ext->rx_c2h += batch.c2h;
+    ext->rx_non_data += batch.non_data;
+    ext->rx_decap_err += batch.decap_err;
+    ext->rx_xdp_drop += batch.xdp_drop;
+    ext->rx_xdp_tx += batch.xdp_tx;
+    ext->rx_xdp_redirect += batch.xdp_redirect;
+    ext->rx_xdp_aborted += batch.xdp_aborted;
+    ext->rx_monitor += batch.monitor;
+    ext->rx_drop_nomem += batch.dropped;
+    if (batch.packets)
+        ext->rx_last_rate = batch.last_rate;
+    if (batch.have_phy)
+        ext->rx_last_pwdb = batch.last_pwdb;
+    spin_unlock_irqrestore(&priv->stats_lock, flags);
+
+    if (batch.dropped)
+        printk_ratelimited(KERN_ERR "%s: Failed to allocate %u RX buffers\n", priv->net_dev->name, batch.dropped);
+    return batch.frames;
+}
 
-            usb_free_coherent(priv->usb_dev, len, tx_buffer, tx_dma); // Free buffer on error
-            priv->tx_skb = NULL; // Clear skb pointer
-            dev_kfree_skb_any(skb); // Free skb
-            usb_free_urb(tx_urb); // Free URB
-            atomic_set(&priv->tx_busy, 0); // Clear busy flag
-            continue; // Try next packet
-        }
+// --- RX URB Submission ---
+// (Re)submit a bulk-in URB. Buffer, length and completion stay as set up in open.
+static int rtl8811au_rx_submit(struct rtl8811au_dev *priv, struct urb *urb, gfp_t gfp) {
+    int retval;
 
-        // Successfully submitted URB, update stats
-        spin_lock_irqsave(&priv->stats_lock, flags);
-        stats->tx_packets++;
-        stats->tx_bytes += len;
-        spin_unlock_irqrestore(&priv->stats_lock, flags);
+    usb_anchor_urb(urb, &priv->rx_anchor);
+    retval = usb_submit_urb(urb, gfp);
+    if (retval)
+        usb_unanchor_urb(urb);
+    return retval;
+}
 
-        // URB is in flight, the worker must wait for completion before sending next packet.
-        // Break out of the loop. The completion handler will clear tx_busy
-        // and potentially re-queue the worker if needed.
-        break;
+static unsigned long rtl8811au_rx_backoff(unsigned int attempts) {
+    unsigned int ms = RTL8811AU_RX_RECOVERY_BASE_MS << min(attempts, 8U);
 
-    } // end while(true)
+    return msecs_to_jiffies(min(ms, (unsigned int)RTL8811AU_RX_RECOVERY_MAX_MS));
+}
 
-    // If we broke out of the loop because the queue was empty,
-    // ensure the network queue is awake (if it was stopped)
-    spin_lock_irqsave(&priv->tx_queue_lock, flags);
-    if (skb_queue_len(&priv->tx_queue) < 50) { // Threshold to wake queue
-       if (netif_queue_stopped(priv->net_dev) && atomic_read(&priv->tx_busy) == 0) {
-           netif_wake_queue(priv->net_dev);
-           printk(KERN_DEBUG "%s: TX queue woken up by worker\n", priv->net_dev->name);
-       }
+// Park a URB for the recovery work instead of retrying it from atomic context
+static void rtl8811au_rx_defer(struct rtl8811au_dev *priv, struct urb *urb, bool halted) {
+    unsigned long flags;
+    unsigned long delay;
+
+    spin_lock_irqsave(&priv->rx_done_lock, flags);
+    if (priv->rx_stopped) {
+        spin_unlock_irqrestore(&priv->rx_done_lock, flags);
+        return;
     }
-    spin_unlock_irqrestore(&priv->tx_queue_lock, flags);
+    list_add_tail(&urb->urb_list, &priv->rx_refill);
+    if (!priv->rx_fail_start)
+        priv->rx_fail_start = ktime_get();
+    if (halted)
+        priv->rx_halted = true;
+    // A stalled endpoint is cleared right away; other failures back off
+    delay = halted ? 0 : rtl8811au_rx_backoff(priv->rx_recovery_attempts);
+    spin_unlock_irqrestore(&priv->rx_done_lock, flags);
+
+    if (halted)
+        mod_delayed_work(priv->wq, &priv->rx_recovery_work, 0);
+    else
+        queue_delayed_work(priv->wq, &priv->rx_recovery_work, delay);
 }
 
-
-// --- TX Completion Handler (runs in atomic context) ---
-static void rtl8811au_tx_complete(struct urb *urb) {
-    // Get private data structure from URB context (FIXED)
-    struct rtl8811au_dev *priv = urb->context;
-    struct sk_buff *skb; // SKB pointer will be retrieved from priv
-    struct net_device_stats *stats;
+// Resubmit from atomic context; on failure the recovery work retries with GFP_KERNEL
+static void rtl8811au_rx_resubmit(struct rtl8811au_dev *priv, struct urb *urb) {
+    struct net_device_stats *stats = &priv->net_dev->stats;
     unsigned long flags;
-    int status = urb->status;
-    bool queue_was_stopped;
-    bool work_queued = false;
+    int retval;
 
-    // Basic sanity checks
-    if (!priv || !priv->net_dev) {
-        printk(KERN_ERR "rtl8811au_wifi: Invalid context or net_dev in TX complete\n");
-        // Can't do much else here, resources might leak if buffer/urb aren't freed
-        if (urb->transfer_buffer) {
-             // Guess size is urb->transfer_buffer_length? Risky.
-             // usb_free_coherent might need device, size, cpu_addr, dma_addr
-        }
-        usb_free_urb(urb);
+    retval = rtl8811au_rx_submit(priv, urb, GFP_ATOMIC);
+    if (retval) {
+        // Log error, increment stats, increment error count
+        priv->rx_error_count++;
+        printk_ratelimited(KERN_ERR "%s: Failed to resubmit RX URB (error %d, count %d)\n", priv->net_dev->name, retval, priv->rx_error_count);
+        spin_lock_irqsave(&priv->stats_lock, flags);
+        stats->rx_errors++;
+        spin_unlock_irqrestore(&priv->stats_lock, flags);
+
+        if (retval != -ENODEV && retval != -ESHUTDOWN)
+            rtl8811au_rx_defer(priv, urb, retval == -EPIPE);
+    }
+}
+
+// First good transfer after an outage: record how long RX was impaired
+static void rtl8811au_rx_recovered(struct rtl8811au_dev *priv) {
+    unsigned long flags;
+    ktime_t start;
+    u64 us;
+
+    spin_lock_irqsave(&priv->rx_done_lock, flags);
+    start = priv->rx_fail_start;
+    // Only count it once every parked URB is back in flight
+    if (!start || !list_empty(&priv->rx_refill)) {
+        spin_unlock_irqrestore(&priv->rx_done_lock, flags);
         return;
     }
+    priv->rx_fail_start = 0;
+    priv->rx_recovery_attempts = 0;
+    spin_unlock_irqrestore(&priv->rx_done_lock, flags);
+
+    us = ktime_us_delta(ktime_get(), start);
+    spin_lock_irqsave(&priv->stats_lock, flags);
+    priv->ext_stats.rx_recoveries++;
+    priv->ext_stats.rx_recovery_last_us = us;
+    priv->ext_stats.rx_recovery_max_us = max(priv->ext_stats.rx_recovery_max_us, us);
+    spin_unlock_irqrestore(&priv->stats_lock, flags);
+
+    printk(KERN_INFO "%s: RX recovered after %llu us\n", priv->net_dev->name, us);
+}
 
-    stats = &priv->net_dev->stats;
-    skb = priv->tx_skb; // Retrieve SKB pointer (FIXED)
+// --- RX Recovery Work (process context) ---
+// Clears a stalled endpoint, resubmits parked URBs with GFP_KERNEL and backs off
+// exponentially while that keeps failing. Escalates to a USB reset (see pre/post_reset)
+// when RX has not come back after RTL8811AU_RX_RECOVERY_MAX_ATTEMPTS rounds.
+static void rtl8811au_rx_recovery_work(struct work_struct *work) {
+    struct rtl8811au_dev *priv = container_of(to_delayed_work(work), struct rtl8811au_dev, rx_recovery_work);
+    struct urb *urb, *tmp;
+    unsigned int attempts;
+    unsigned long flags;
+    LIST_HEAD(urbs);
+    bool halted;
+    int ret = 0;
 
-    if (!skb) {
-       printk(KERN_ERR "%s: TX complete but skb pointer was NULL!\n", priv->net_dev->name);
-       // Don't try to free skb, but do free USB resources
+    spin_lock_irqsave(&priv->rx_done_lock, flags);
+    if (priv->rx_stopped) {
+        spin_unlock_irqrestore(&priv->rx_done_lock, flags);
+        return;
+    }
+    attempts = ++priv->rx_recovery_attempts;
+    halted = priv->rx_halted;
+    priv->rx_halted = false;
+    list_splice_init(&priv->rx_refill, &urbs);
+    spin_unlock_irqrestore(&priv->rx_done_lock, flags);
+
+    spin_lock_irqsave(&priv->stats_lock, flags);
+    priv->ext_stats.rx_recovery_rounds++;
+    spin_unlock_irqrestore(&priv->stats_lock, flags);
+
+    if (attempts > RTL8811AU_RX_RECOVERY_MAX_ATTEMPTS) {
+        printk(KERN_CRIT "%s: RX still failing after %u recovery rounds, resetting device\n",
+               priv->net_dev->name, attempts - 1);
+        spin_lock_irqsave(&priv->stats_lock, flags);
+        priv->ext_stats.rx_resets++;
+        spin_unlock_irqrestore(&priv->stats_lock, flags);
+        // post_reset restarts RX from scratch; the parked URBs are simply not in flight
+        usb_queue_reset_device(priv->usb_intf);
+        return;
     }
 
-    // Check URB status
-    if (status != 0) {
-        printk(KERN_ERR "%s: TX URB failed (status %d)\n", priv->net_dev->name, status);
+    if (halted) {
+        ret = usb_clear_halt(priv->usb_dev, usb_rcvbulkpipe(priv->usb_dev, priv->bulk_in_endpoint));
         spin_lock_irqsave(&priv->stats_lock, flags);
-        stats->tx_errors++;
-        // Note: tx_dropped was already counted if submit failed.
-        // If it fails here, it means submit succeeded but transfer failed.
+        priv->ext_stats.rx_halt_clears++;
         spin_unlock_irqrestore(&priv->stats_lock, flags);
-        // Status codes like -EPIPE, -ENODEV indicate device issues
+        if (ret)
+            printk(KERN_ERR "%s: Failed to clear RX halt (error %d)\n", priv->net_dev->name, ret);
     }
 
-    // Free the DMA buffer associated with this URB
-    usb_free_coherent(priv->usb_dev,
-                      urb->transfer_buffer_length, // Size used in alloc
-                      urb->transfer_buffer,        // CPU address
-                      urb->transfer_dma);          // DMA address
+    priv->rx_error_count = 0; // Fresh error budget for the resubmitted URBs
+    list_for_each_entry_safe(urb, tmp, &urbs, urb_list) {
+        if (ret)
+            break;
+        list_del_init(&urb->urb_list);
+        ret = rtl8811au_rx_submit(priv, urb, GFP_KERNEL);
+        if (ret)
+            list_add(&urb->urb_list, &urbs); // Keep it with the rest for the next round
+    }
 
-    // Free the SKB (if we have a pointer to it)
-    if (skb) {
-        priv->tx_skb = NULL; // Clear pointer before freeing
-        dev_kfree_skb_any(skb);
+    if (ret) {
+        printk_ratelimited(KERN_ERR "%s: RX recovery round %u failed (error %d)\n", priv->net_dev->name, attempts, ret);
+        spin_lock_irqsave(&priv->rx_done_lock, flags);
+        list_splice(&urbs, &priv->rx_refill);
+        if (ret == -EPIPE)
+            priv->rx_halted = true;
+        spin_unlock_irqrestore(&priv->rx_done_lock, flags);
+        queue_delayed_work(priv->wq, &priv->rx_recovery_work, rtl8811au_rx_backoff(attempts));
     }
+}
 
-    // Free the URB itself
-    usb_free_urb(urb);
+// --- NAPI Poll (softirq context) ---
+// Drains bulk-in transfers handed over by rtl8811au_rx_complete and resubmits each URB
+// once its buffer has been consumed. Budget is counted in frames; a transfer is always
+// processed whole.
+static int rtl8811au_poll(struct napi_struct *napi, int budget) {
+    struct rtl8811au_dev *priv = container_of(napi, struct rtl8811au_dev, napi);
+    struct urb *urb;
+    unsigned long flags;
+    int work = 0;
+    u64 t0 = rtl8811au_prof_start();
+
+    while (work < budget) {
+        spin_lock_irqsave(&priv->rx_done_lock, flags);
+        urb = list_first_entry_or_null(&priv->rx_done, struct urb, urb_list);
+        if (urb)
+            list_del_init(&urb->urb_list);
+        spin_unlock_irqrestore(&priv->rx_done_lock, flags);
+        if (!urb)
+            break;
 
-    // --- TX is no longer busy ---
-    // Clear the busy flag *before* checking queue, ensures worker won't race
-    atomic_set(&priv->tx_busy, 0);
+        work += rtl8811au_rx_process(priv, urb->transfer_buffer, urb->actual_length);
+        rtl8811au_rx_resubmit(priv, urb);
+    }
 
-    // Check if more packets are waiting and schedule worker if needed
-    spin_lock_irqsave(&priv->tx_queue_lock, flags);
-    queue_was_stopped = netif_queue_stopped(priv->net_dev);
-    if (skb_queue_len(&priv->tx_queue) > 0) {
-        // More work to do, queue the worker again
-        queue_work(priv->tx_wq, &priv->tx_worker_work);
-        work_queued = true; // Worker will handle waking queue if necessary later
-    } else {
-        // Queue is empty, wake it up if it was stopped
-        if (queue_was_stopped) {
-             netif_wake_queue(priv->net_dev);
-             printk(KERN_DEBUG "%s: TX queue woken up by completion\n", priv->net_dev->name);
-        }
+    if (priv->xdp_flush) {
+        xdp_do_flush();
+        priv->xdp_flush = false;
     }
-    spin_unlock_irqrestore(&priv->tx_queue_lock, flags);
+    if (work)
+        usb_mark_last_busy(priv->usb_dev); // Push autosuspend out while frames arrive
+    rtl8811au_prof_end(priv, t0, RTL8811AU_PROF_RX_POLL, work);
 
+    if (work < budget) {
+        napi_complete_done(napi, work);
+        return work;
+    }
+    return budget;
 }
 
 // --- RX Completion Handler (runs in atomic context) ---
 static void rtl8811au_rx_complete(struct urb *urb) {
     struct rtl8811au_dev *priv = urb->context;
-    struct sk_buff *skb;
     int status = urb->status;
-    int retval;
     struct net_device_stats *stats;
     unsigned long flags;
+    u64 t0 = rtl8811au_prof_start();
 
     // Basic sanity check
     if (!priv || !priv->net_dev) {
@@ -483,43 +2682,22 @@ static void rtl8811au_rx_complete(struct urb *urb) {
     case 0: // Success
         // Reset error counter on success
         priv->rx_error_count = 0;
+        if (unlikely(READ_ONCE(priv->rx_fail_start)))
+            rtl8811au_rx_recovered(priv);
 
         // Check if we actually received data
         if (urb->actual_length == 0) {
             printk(KERN_DEBUG "%s: RX URB success but zero length\n", priv->net_dev->name);
-            goto resubmit_rx; // Just resubmit the URB
+            break; // Just resubmit the URB
         }
 
-        // Allocate an SKB for the received data
-        // Add headroom for potential later processing
-        skb = dev_alloc_skb(urb->actual_length + NET_IP_ALIGN);
-        if (skb) {
-             // Ensure IP header will be aligned
-            skb_reserve(skb, NET_IP_ALIGN);
-            // Copy data from our DMA buffer to the skb
-            memcpy(skb_put(skb, urb->actual_length), priv->rx_buffer, urb->actual_length);
-
-            // Set up SKB metadata
-            skb->dev = priv->net_dev;
-            skb->protocol = eth_type_trans(skb, priv->net_dev);
-            skb->ip_summed = CHECKSUM_NONE; // Assume no checksum offload
-
-            // Send it up the network stack
-            netif_rx(skb);
-
-            // Update stats
-            spin_lock_irqsave(&priv->stats_lock, flags);
-            stats->rx_packets++;
-            stats->rx_bytes += urb->actual_length;
-            spin_unlock_irqrestore(&priv->stats_lock, flags);
-        } else {
-            printk(KERN_ERR "%s: Failed to allocate skb for RX (len %d)\n", priv->net_dev->name, urb->actual_length);
-            spin_lock_irqsave(&priv->stats_lock, flags);
-            stats->rx_dropped++;
-            spin_unlock_irqrestore(&priv->stats_lock, flags);
-            // Continue to resubmit URB even if skb allocation failed
-        }
-        break; // Go to resubmit
+        // Hand the buffer to NAPI; the poll loop resubmits the URB once it is parsed
+        spin_lock_irqsave(&priv->rx_done_lock, flags);
+        list_add_tail(&urb->urb_list, &priv->rx_done);
+        spin_unlock_irqrestore(&priv->rx_done_lock, flags);
+        napi_schedule(&priv->napi);
+        rtl8811au_prof_end(priv, t0, RTL8811AU_PROF_RX_COMPLETE, 1);
+        return;
 
     // Handle errors that mean the device is gone or stopping
     case -ENOENT:      // URB killed
@@ -535,48 +2713,32 @@ static void rtl8811au_rx_complete(struct urb *urb) {
         printk(KERN_ERR "%s: RX URB failed (status %d, count %d)\n", priv->net_dev->name, status, priv->rx_error_count);
         spin_lock_irqsave(&priv->stats_lock, flags);
         stats->rx_errors++;
+        priv->ext_stats.rx_drop_urb_err++;
         spin_unlock_irqrestore(&priv->stats_lock, flags);
 
+        // A stalled endpoint needs usb_clear_halt(), which sleeps
+        if (status == -EPIPE) {
+            rtl8811au_rx_defer(priv, urb, true);
+            return;
+        }
+
         // Check if we exceeded the consecutive error limit
         if (priv->rx_error_count > MAX_RX_ERRORS) {
-            printk(KERN_CRIT "%s: Too many consecutive RX errors (%d). Stopping RX.\n", priv->net_dev->name, priv->rx_error_count);
-            // TODO: Maybe notify higher layers or try a device reset?
-            return; // Stop submitting RX URBs
+            printk_ratelimited(KERN_ERR "%s: Too many consecutive RX errors (%d), deferring to recovery\n", priv->net_dev->name, priv->rx_error_count);
+            rtl8811au_rx_defer(priv, urb, false);
+            return;
         }
 
         // FIXED: Removed msleep(100) - sleeping is bad in atomic context.
-        // If errors persist, the error counter will stop resubmission.
-        // For transient errors (like -EPIPE sometimes), immediate retry might work.
+        // For transient errors an immediate retry usually works; persistent ones end up
+        // in the recovery work above.
         break; // Go to resubmit
     }
 
-resubmit_rx:
-    // Resubmit the URB for next packet (unless we returned due to fatal error/too many errors)
-    // Re-use the same URB and buffer
-    usb_fill_bulk_urb(priv->rx_urb, priv->usb_dev,
-                      usb_rcvbulkpipe(priv->usb_dev, priv->bulk_in_endpoint),
-                      priv->rx_buffer, MAX_PACKET_SIZE,
-                      rtl8811au_rx_complete, priv);
-    priv->rx_urb->transfer_flags |= URB_NO_TRANSFER_DMA_MAP;
-    priv->rx_urb->transfer_dma = priv->rx_dma;
-
-
+    // Resubmit the URB for next packet (unless it was handed to the recovery work)
     // Use GFP_ATOMIC since we are in interrupt context (completion handler)
-    retval = usb_submit_urb(priv->rx_urb, GFP_ATOMIC);
-    if (retval) {
-        // Log error, increment stats, increment error count
-        priv->rx_error_count++;
-        printk(KERN_ERR "%s: Failed to resubmit RX URB (error %d, count %d)\n", priv->net_dev->name, retval, priv->rx_error_count);
-        spin_lock_irqsave(&priv->stats_lock, flags);
-        stats->rx_errors++;
-        spin_unlock_irqrestore(&priv->stats_lock, flags);
-
-        if (priv->rx_error_count > MAX_RX_ERRORS) {
-             printk(KERN_CRIT "%s: Too many consecutive RX errors (%d) after failed resubmit. Stopping RX.\n", priv->net_dev->name, priv->rx_error_count);
-             // Free resources here? No, stop should handle it.
-        }
-        // Don't loop trying to resubmit here if it fails.
-    }
+    rtl8811au_rx_resubmit(priv, urb);
+    rtl8811au_prof_end(priv, t0, RTL8811AU_PROF_RX_COMPLETE, 1);
 }
 
 // --- Set MAC Address ---
@@ -592,13 +2754,101 @@ static int rtl8811au_set_mac_address(struct net_device *dev, void *addr) {
     eth_hw_addr_set(dev, sa->sa_data);
     printk(KERN_INFO "%s: MAC address set to %pM\n", dev->name, dev->dev_addr);
 
-    // TODO: Need to send command to hardware to set its MAC address filter
-    // This requires device-specific control transfer knowledge.
-    // Example: rtlwifi_set_mac_addr(priv->hw, sa->sa_data);
+    // addr2 of every TX frame comes from the header template
+    if (rtnl_dereference(priv->hdr_cache)) {
+        int ret = rtl8811au_update_hdr_cache(priv, priv->bssid);
+        if (ret)
+            return ret;
+    }
+
+    // Program the hardware address filter (REG_MACID) from process context
+    spin_lock_irq(&priv->rx_mode_lock);
+    memcpy(priv->regs.macid, dev->dev_addr, ETH_ALEN);
+    spin_unlock_irq(&priv->rx_mode_lock);
+    queue_work(priv->wq, &priv->rx_mode_work);
 
     return 0;
 }
 
+// --- RX Mode (Hardware Filtering) ---
+// Called in atomic context with the address list locked. Computes RCR and the multicast
+// hash from the netdev flags and hands them to rtl8811au_rx_mode_work.
+static void rtl8811au_set_rx_mode(struct net_device *dev) {
+    struct rtl8811au_dev *priv = netdev_priv(dev);
+    struct netdev_hw_addr *ha;
+    u32 rcr = RTL8811AU_RCR_STATION;
+    u8 mar[8] = {};
+    unsigned long flags;
+    u32 bit;
+
+    if (READ_ONCE(priv->monitor)) {
+        // Capture everything, including CRC failures (flagged BADFCS in radiotap) and ICV failures
+        rcr = RTL8811AU_RCR_MONITOR;
+        memset(mar, 0xff, sizeof(mar));
+    } else if (dev->flags & IFF_PROMISC) {
+        rcr |= RCR_AAP;
+        rcr &= ~(RCR_CBSSID_DATA | RCR_CBSSID_BCN);
+        memset(mar, 0xff, sizeof(mar));
+    } else if (dev->flags & IFF_ALLMULTI) {
+        memset(mar, 0xff, sizeof(mar));
+    } else {
+        // 64-bin hash indexed by the top 6 bits of the Ethernet CRC
+        netdev_for_each_mc_addr(ha, dev) {
+            bit = ether_crc(ETH_ALEN, ha->addr) >> 26;
+            mar[bit >> 3] |= BIT(bit & 7);
+        }
+    }
+
+    spin_lock_irqsave(&priv->rx_mode_lock, flags);
+    priv->regs.rcr = rcr;
+    memcpy(priv->regs.mar, mar, sizeof(mar));
+    spin_unlock_irqrestore(&priv->rx_mode_lock, flags);
+
+    queue_work(priv->wq, &priv->rx_mode_work);
+}
+
+// --- sysfs ---
+// /sys/class/net/<dev>/tx_cpumask: CPUs the TX thread may run on, e.g. the CPU that
+// services this adapter's xHCI interrupt
+static ssize_t tx_cpumask_show(struct device *d, struct device_attribute *attr, char *buf) {
+    struct rtl8811au_dev *priv = netdev_priv(to_net_dev(d));
+
+    return cpumap_print_to_pagebuf(false, buf, priv->tx_cpumask);
+}
+
+static ssize_t tx_cpumask_store(struct device *d, struct device_attribute *attr,
+                                const char *buf, size_t len) {
+    struct rtl8811au_dev *priv = netdev_priv(to_net_dev(d));
+    cpumask_var_t mask;
+    int ret;
+
+    if (!alloc_cpumask_var(&mask, GFP_KERNEL))
+        return -ENOMEM;
+
+    ret = cpumask_parse(buf, mask);
+    if (!ret && !cpumask_intersects(mask, cpu_online_mask))
+        ret = -EINVAL;
+    if (!ret)
+        ret = set_cpus_allowed_ptr(priv->tx_thread->task, mask);
+    if (!ret) {
+        cpumask_copy(priv->tx_cpumask, mask);
+        printk(KERN_INFO "%s: TX thread CPUs set to %*pbl\n", priv->net_dev->name, cpumask_pr_args(mask));
+    }
+
+    free_cpumask_var(mask);
+    return ret ? ret : len;
+}
+static DEVICE_ATTR_RW(tx_cpumask);
+
+static struct attribute *rtl8811au_attrs[] = {
+    &dev_attr_tx_cpumask.attr,
+    NULL,
+};
+
+static const struct attribute_group rtl8811au_attr_group = {
+    .attrs = rtl8811au_attrs,
+};
+
 // --- Probe Function ---
 static int rtl8811au_probe(struct usb_interface *interface, const struct usb_device_id *id) {
     struct usb_device *usb_dev = interface_to_usbdev(interface);
@@ -612,13 +2862,14 @@ static int rtl8811au_probe(struct usb_interface *interface, const struct usb_dev
 
     printk(KERN_INFO "rtl8811au_wifi: Probing device (Vendor: 0x%04x, Product: 0x%04x)\n", id->idVendor, id->idProduct);
 
-    // Use devm_kzalloc for automatic cleanup on driver detach
-    priv = devm_kzalloc(&interface->dev, sizeof(*priv), GFP_KERNEL);
-    if (!priv) {
-        ret = -ENOMEM;
-        dev_err(&interface->dev, "Failed to allocate device structure\n");
-        return ret;
+    // The device context lives in the netdev private area, so there is exactly one copy
+    net_dev = alloc_etherdev(sizeof(*priv));
+    if (!net_dev) {
+        dev_err(&interface->dev, "Failed to allocate network device\n");
+        return -ENOMEM;
     }
+    priv = netdev_priv(net_dev);
+    priv->net_dev = net_dev;
 
     priv->usb_dev = usb_get_dev(usb_dev); // Increment refcount
     priv->usb_intf = interface;
@@ -633,10 +2884,12 @@ static int rtl8811au_probe(struct usb_interface *interface, const struct usb_dev
         struct usb_endpoint_descriptor *ep = &alt->endpoint[i].desc;
         if (!priv->bulk_in_endpoint && usb_endpoint_is_bulk_in(ep)) {
             priv->bulk_in_endpoint = ep->bEndpointAddress;
+            priv->bulk_in_maxp = usb_endpoint_maxp(ep);
             printk(KERN_INFO "rtl8811au_wifi: Found bulk IN endpoint: 0x%02x\n", priv->bulk_in_endpoint);
         }
         if (!priv->bulk_out_endpoint && usb_endpoint_is_bulk_out(ep)) {
             priv->bulk_out_endpoint = ep->bEndpointAddress;
+            priv->bulk_out_maxp = usb_endpoint_maxp(ep);
             printk(KERN_INFO "rtl8811au_wifi: Found bulk OUT endpoint: 0x%02x\n", priv->bulk_out_endpoint);
         }
     }
@@ -647,14 +2900,24 @@ static int rtl8811au_probe(struct usb_interface *interface, const struct usb_dev
         goto err_put_usb;
     }
 
+    // Per-CPU handler timing counters (see rtl8811au_prof_end)
+    priv->prof = netdev_alloc_pcpu_stats(struct rtl8811au_prof_stats);
+    if (!priv->prof) {
+        ret = -ENOMEM;
+        goto err_put_usb;
+    }
+
     // Initialize spinlocks, queue, atomic variable
     // spin_lock_init(&priv->tx_lock); // Removed, unused
     spin_lock_init(&priv->tx_queue_lock);
     spin_lock_init(&priv->stats_lock);
     skb_queue_head_init(&priv->tx_queue);
     atomic_set(&priv->tx_busy, 0);
+    priv->last_rssi = -100; // No frame seen yet
     // init_completion(&priv->tx_complete); // Removed, unused
     priv->tx_skb = NULL; // Initialize tx skb pointer
+    __skb_queue_head_init(&priv->tx_agg_skbs); // Owned by whoever holds tx_busy
+    init_usb_anchor(&priv->tx_anchor);
 
     // --- Request Firmware ---
     ret = request_firmware(&priv->firmware, RTL8811AU_FIRMWARE, &interface->dev);
@@ -683,8 +2946,8 @@ static int rtl8811au_probe(struct usb_interface *interface, const struct usb_dev
     // wiphy->privid = some_unique_id; // Not strictly needed here
 
     // Define supported interface modes (e.g., Station)
-    wiphy->interface_modes = BIT(NL80211_IFTYPE_STATION);
-    // TODO: Add other modes if supported (AP, Monitor, etc.)
+    wiphy->interface_modes = BIT(NL80211_IFTYPE_STATION) | BIT(NL80211_IFTYPE_MONITOR);
+    // TODO: Add other modes if supported (AP, etc.)
 
     // --- Define Supported Bands/Channels/Rates ---
     // Allocate 2GHz band structure (use devm_ for interface-bound resources)
@@ -737,43 +3000,80 @@ static int rtl8811au_probe(struct usb_interface *interface, const struct usb_dev
     wiphy->bands[NL80211_BAND_2GHZ] = band_2g;
     // wiphy->bands[NL80211_BAND_5GHZ] = band_5g; // If defined
 
-    // --- Allocate and Setup Netdevice ---
-    // Use alloc_etherdev for standard Ethernet setup
-    net_dev = alloc_etherdev(sizeof(struct rtl8811au_dev));
-    if (!net_dev) {
-        ret = -ENOMEM;
-        dev_err(&interface->dev, "Failed to allocate network device\n");
-        goto err_free_wiphy; // devm handles bands/rates/channels
-    }
-    priv->net_dev = net_dev; // Link net_dev in our priv struct
-    // Copy needed info from interface's priv to net_dev's priv
-    // netdev_priv gets the area allocated by alloc_etherdev
-    struct rtl8811au_dev *netdev_priv_data = netdev_priv(net_dev);
-    memcpy(netdev_priv_data, priv, sizeof(*priv)); // Copy basic pointers (usb_dev, endpoints, etc.)
-
+    // --- Setup Netdevice ---
     SET_NETDEV_DEV(net_dev, &interface->dev); // Associate net_dev with USB interface device
     net_dev->netdev_ops = &rtl8811au_netdev_ops; // Assign network operations
+    net_dev->ethtool_ops = &rtl8811au_ethtool_ops; // Extended RX/TX statistics
+    // Room to turn the Ethernet header into TX descriptor + 802.11 + LLC/SNAP in place
+    net_dev->needed_headroom = sizeof(struct rtl8811au_tx_hdr) - ETH_HLEN;
+    net_dev->watchdog_timeo = RTL8811AU_TX_TIMEOUT;
+    net_dev->max_mtu = RTL8811AU_MAX_MTU;
+    net_dev->sysfs_groups[0] = &rtl8811au_attr_group; // tx_cpumask
     // Assign wireless extensions pointer (legacy, but some tools might use it)
     // net_dev->wireless_handlers = &rtl8811au_whandler_def;
-    // Assign cfg80211 pointer
-    net_dev->ieee80211_ptr = &rtl8811au_wdev;
-    rtl8811au_wdev.wiphy = wiphy; // Link wireless_dev to wiphy
-    // rtl8811au_wdev.netdev = net_dev; // Set back pointer if needed by wdev ops
+    // Assign cfg80211 pointer; each adapter has its own wireless_dev
+    priv->wdev.wiphy = wiphy;
+    priv->wdev.iftype = NL80211_IFTYPE_STATION;
+    priv->wdev.netdev = net_dev;
+    net_dev->ieee80211_ptr = &priv->wdev;
 
     // Set a random MAC address initially. Should be read from device later.
     eth_hw_addr_random(net_dev);
     printk(KERN_INFO "rtl8811au_wifi: Assigned random MAC %pM\n", net_dev->dev_addr);
     // TODO: Read MAC from hardware EEPROM/OTP and use it instead.
 
-    // --- Initialize TX Workqueue ---
-    // Create workqueue after net_dev is set up
-    priv->tx_wq = create_singlethread_workqueue(net_dev->name);
-    if (!priv->tx_wq) {
-        dev_err(&interface->dev, "Failed to create TX workqueue\n");
+    // --- Initialize TX Thread and Workqueue ---
+    // Named after the USB interface: the netdev name is still a "wlan%d" template here.
+    // A dedicated kthread rather than a workqueue so each adapter's TX path can be given
+    // its own priority and CPU affinity (sysfs tx_cpumask). It is single-threaded, so
+    // the TX worker and the TX watchdog never run concurrently.
+    if (!zalloc_cpumask_var(&priv->tx_cpumask, GFP_KERNEL)) {
+        ret = -ENOMEM;
+        goto err_free_wiphy;
+    }
+    cpumask_copy(priv->tx_cpumask, cpu_possible_mask);
+    priv->tx_thread = kthread_create_worker(0, "r8811tx/%s", dev_name(&interface->dev));
+    if (IS_ERR(priv->tx_thread)) {
+        dev_err(&interface->dev, "Failed to create TX thread\n");
+        ret = PTR_ERR(priv->tx_thread);
+        goto err_free_cpumask;
+    }
+    if (tx_rt)
+        sched_set_fifo_low(priv->tx_thread->task);
+    else
+        set_user_nice(priv->tx_thread->task, RTL8811AU_TX_NICE);
+
+    priv->wq = alloc_ordered_workqueue("rtl8811au/%s", 0, dev_name(&interface->dev));
+    if (!priv->wq) {
+        dev_err(&interface->dev, "Failed to create workqueue\n");
         ret = -ENOMEM;
-        goto err_free_netdev;
+        goto err_destroy_wq;
     }
-    INIT_WORK(&priv->tx_worker_work, rtl8811au_tx_worker);
+    kthread_init_work(&priv->tx_worker_work, rtl8811au_tx_worker);
+    kthread_init_delayed_work(&priv->tx_watchdog_work, rtl8811au_tx_watchdog);
+    hrtimer_init(&priv->tx_coal_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+    priv->tx_coal_timer.function = rtl8811au_tx_coal_timer;
+    priv->tx_coal_frames = RTL8811AU_TX_AGG_MAX_FRAMES;
+    INIT_WORK(&priv->autosuspend_work, rtl8811au_autosuspend_work);
+    priv->autosuspend_ms = RTL8811AU_AUTOSUSPEND_DEFAULT_MS;
+    priv->ext_stats.pm_autosuspend_ms = priv->autosuspend_ms;
+
+    // --- RX Polling and XDP ---
+    INIT_LIST_HEAD(&priv->rx_done);
+    spin_lock_init(&priv->rx_done_lock);
+    init_usb_anchor(&priv->rx_anchor);
+    INIT_LIST_HEAD(&priv->rx_refill);
+    INIT_DELAYED_WORK(&priv->rx_recovery_work, rtl8811au_rx_recovery_work);
+    priv->rx_stopped = true; // Until open
+
+    // --- Hardware RX Filtering ---
+    spin_lock_init(&priv->rx_mode_lock);
+    mutex_init(&priv->reg_mutex);
+    priv->hw_regs_valid = false; // Chip state unknown until the first full write
+    INIT_WORK(&priv->rx_mode_work, rtl8811au_rx_mode_work);
+    netif_napi_add(net_dev, &priv->napi, rtl8811au_poll);
+    xdp_set_features_flag(net_dev, NETDEV_XDP_ACT_BASIC | NETDEV_XDP_ACT_REDIRECT |
+                                   NETDEV_XDP_ACT_NDO_XMIT);
 
     // --- Register Wiphy and Netdevice ---
     ret = wiphy_register(wiphy);
@@ -792,6 +3092,11 @@ static int rtl8811au_probe(struct usb_interface *interface, const struct usb_dev
     }
     printk(KERN_INFO "rtl8811au_wifi: netdev %s registered\n", net_dev->name);
 
+    // Runtime PM; the delay is adapted on every runtime resume
+    pm_runtime_set_autosuspend_delay(&usb_dev->dev, priv->autosuspend_ms);
+    if (autosuspend)
+        usb_enable_autosuspend(usb_dev);
+
     printk(KERN_INFO "rtl8811au_wifi: Probe successful for %s\n", net_dev->name);
     return 0; // Success
 
@@ -800,12 +3105,11 @@ err_unregister_wiphy:
     wiphy_unregister(wiphy);
     // Fall through to destroy WQ
 err_destroy_wq:
-    if (priv->tx_wq) {
-        destroy_workqueue(priv->tx_wq);
-    }
-    // Fall through to free netdev
-err_free_netdev:
-    free_netdev(net_dev); // Free net_device allocated with alloc_etherdev
+    if (priv->wq)
+        destroy_workqueue(priv->wq);
+    kthread_destroy_worker(priv->tx_thread);
+err_free_cpumask:
+    free_cpumask_var(priv->tx_cpumask);
     // Fall through to free wiphy
 err_free_wiphy:
     wiphy_free(wiphy); // Free wiphy if registration failed or didn't happen
@@ -816,7 +3120,8 @@ err_release_firmware:
 err_put_usb:
     usb_set_intfdata(interface, NULL); // Clear association
     usb_put_dev(usb_dev); // Decrement refcount
-    // devm_kzalloc for priv will be cleaned up automatically
+    free_percpu(priv->prof);
+    free_netdev(net_dev); // Frees priv as well
 
     printk(KERN_ERR "rtl8811au_wifi: Probe failed with error %d\n", ret);
     return ret;
@@ -826,65 +3131,239 @@ err_put_usb:
 static void rtl8811au_disconnect(struct usb_interface *interface) {
     // Get private data structure back from interface
     struct rtl8811au_dev *priv = usb_get_intfdata(interface);
+    struct net_device *net_dev;
 
     if (!priv) {
         printk(KERN_INFO "rtl8811au_wifi: Disconnect called on non-probed interface?\n");
         return;
     }
+    net_dev = priv->net_dev; // priv lives inside it, so it is freed last
 
-    printk(KERN_INFO "rtl8811au_wifi: Disconnecting device %s\n", priv->net_dev ? priv->net_dev->name : "(null net_dev)");
+    printk(KERN_INFO "rtl8811au_wifi: Disconnecting device %s\n", net_dev->name);
 
     // Unregister netdevice first (stops traffic, calls ndo_stop)
-    if (priv->net_dev) {
-        unregister_netdev(priv->net_dev);
-        // Note: free_netdev is called automatically by unregister_netdev
-        // if the device refcount drops to zero (which it should here).
-        priv->net_dev = NULL; // Clear our pointer
-    }
+    unregister_netdev(net_dev);
+
+    // Unregister wiphy; it only holds a pointer to priv
+    wiphy_unregister(priv->wiphy);
+
+    // RX URB/buffer cleanup happens in ndo_stop, which is called by unregister_netdev.
+    // Repeat it in case stop never ran; this also cancels the RX recovery work.
+    rtl8811au_kill_rx_urbs(priv);
+    rtl8811au_free_rx_urbs(priv, priv->rx_urbs);
+
+    // No filter updates or PM tuning once the netdev is gone
+    cancel_work_sync(&priv->rx_mode_work);
+    cancel_work_sync(&priv->autosuspend_work);
+    destroy_workqueue(priv->wq);
+
+    // Clean up TX thread (FIXED: Moved here from stop)
+    hrtimer_cancel(&priv->tx_coal_timer);
+    kthread_cancel_delayed_work_sync(&priv->tx_watchdog_work);
+    kthread_cancel_work_sync(&priv->tx_worker_work); // Ensure TX worker isn't running
+    kthread_destroy_worker(priv->tx_thread);
+    free_cpumask_var(priv->tx_cpumask);
+    skb_queue_purge(&priv->tx_queue); // Frames that never made it out
+    kfree(priv->tx_agg_buf);
+    free_percpu(priv->prof);
+
+    // No readers are left once the netdev is gone
+    kfree(rcu_dereference_protected(priv->hdr_cache, 1));
+    RCU_INIT_POINTER(priv->hdr_cache, NULL);
 
-    // Unregister wiphy
-    if (priv->wiphy) {
-        wiphy_unregister(priv->wiphy);
-        wiphy_free(priv->wiphy); // Free wiphy structure
-        priv->wiphy = NULL; // Clear our pointer
-    }
+    // Release firmware
+    release_firmware(priv->firmware);
+
+    // Cleanup remaining USB resources
+    usb_set_intfdata(interface, NULL); // Clear association
+    usb_put_dev(priv->usb_dev); // Decrement refcount taken in probe
+
+    // devm_kzalloc'd memory (band, channels, rates) is freed automatically
+    wiphy_free(priv->wiphy);
+    free_netdev(net_dev); // Frees priv as well
+
+    printk(KERN_INFO "rtl8811au_wifi: Device disconnected\n");
+}
 
-    // Clean up TX workqueue (FIXED: Moved here from stop)
-    if (priv->tx_wq) {
-        cancel_work_sync(&priv->tx_worker_work); // Ensure TX worker isn't running
-        destroy_workqueue(priv->tx_wq); // Destroy the workqueue
-        priv->tx_wq = NULL;
+// --- Quiesce / Restore ---
+// Shared by suspend/resume and pre/post_reset. Quiescing stops every URB the driver
+// has in flight; restoring rebuilds the chip state from what the driver already holds
+// (cached firmware, register shadow) instead of going through a cold init.
+static void rtl8811au_quiesce(struct rtl8811au_dev *priv) {
+    // Whatever comes next (reset, suspend) may clear the chip registers
+    mutex_lock(&priv->reg_mutex);
+    priv->hw_regs_valid = false;
+    mutex_unlock(&priv->reg_mutex);
+
+    if (netif_running(priv->net_dev)) {
+        napi_disable(&priv->napi);
+        rtl8811au_kill_rx_urbs(priv);
+        priv->rx_quiesced = true;
     }
+    kthread_cancel_delayed_work_sync(&priv->tx_watchdog_work);
+    usb_kill_anchored_urbs(&priv->tx_anchor);
+}
+
+static int rtl8811au_restore(struct rtl8811au_dev *priv) {
+    struct rtl8811au_reg_shadow want;
+    int ret;
 
-    // RX URB/buffer cleanup happens in ndo_stop, which is called by unregister_netdev
-    // Just ensure pointers are null if stop wasn't called for some reason.
-    if (priv->rx_urb) {
-       usb_kill_urb(priv->rx_urb);
-       usb_free_urb(priv->rx_urb);
-       priv->rx_urb = NULL;
+    // TODO: Download priv->firmware (kept from probe, no request_firmware here) once
+    // the download sequence exists
+
+    // The chip may have lost its MAC state; rewrite every filter register from the shadow
+    spin_lock_irq(&priv->rx_mode_lock);
+    want = priv->regs;
+    spin_unlock_irq(&priv->rx_mode_lock);
+    mutex_lock(&priv->reg_mutex);
+    ret = rtl8811au_write_shadow(priv, &want, true);
+    mutex_unlock(&priv->reg_mutex);
+    if (ret)
+        printk(KERN_ERR "%s: Failed to restore filters (error %d)\n", priv->net_dev->name, ret);
+
+    // Only what quiesce stopped: ndo_open resuming the device has not built the RX pool yet
+    if (priv->rx_quiesced) {
+        priv->rx_quiesced = false;
+        // NAPI first: an URB completing straight away schedules poll. On failure NAPI
+        // stays enabled so ndo_stop can disable it.
+        napi_enable(&priv->napi);
+        ret = rtl8811au_start_rx(priv);
+        if (ret) {
+            printk(KERN_ERR "%s: Failed to restart RX (error %d)\n", priv->net_dev->name, ret);
+            return ret;
+        }
     }
-    if (priv->rx_buffer) {
-        usb_free_coherent(priv->usb_dev, MAX_PACKET_SIZE, priv->rx_buffer, priv->rx_dma);
-        priv->rx_buffer = NULL;
+
+    // Frames queued while the device was down go out now
+    rtl8811au_kick_tx(priv);
+    return 0;
+}
+
+// --- USB Reset Handling ---
+// Called by the USB core around a port reset, including the ones queued by the RX
+// recovery work and the TX watchdog.
+static int rtl8811au_pre_reset(struct usb_interface *interface) {
+    struct rtl8811au_dev *priv = usb_get_intfdata(interface);
+
+    if (!priv || !priv->net_dev)
+        return 0;
+
+    printk(KERN_INFO "%s: Preparing for USB reset\n", priv->net_dev->name);
+    netif_device_detach(priv->net_dev);
+    rtl8811au_quiesce(priv);
+    return 0;
+}
+
+static int rtl8811au_post_reset(struct usb_interface *interface) {
+    struct rtl8811au_dev *priv = usb_get_intfdata(interface);
+
+    if (!priv || !priv->net_dev)
+        return 0;
+
+    // On failure leave the device detached; the user has to bring it down and up again
+    if (rtl8811au_restore(priv))
+        return 0;
+
+    netif_device_attach(priv->net_dev);
+    printk(KERN_INFO "%s: USB reset complete\n", priv->net_dev->name);
+    return 0;
+}
+
+// --- Power Management ---
+static void rtl8811au_autosuspend_work(struct work_struct *work) {
+    struct rtl8811au_dev *priv = container_of(work, struct rtl8811au_dev, autosuspend_work);
+
+    pm_runtime_set_autosuspend_delay(&priv->usb_dev->dev, READ_ONCE(priv->autosuspend_ms));
+}
+
+static int rtl8811au_suspend(struct usb_interface *interface, pm_message_t message) {
+    struct rtl8811au_dev *priv = usb_get_intfdata(interface);
+    unsigned long flags;
+
+    if (!priv || !priv->net_dev)
+        return 0;
+
+    if (PMSG_IS_AUTO(message)) {
+        // Frames waiting for the worker: stay up rather than bounce straight back
+        if (atomic_read(&priv->tx_busy) || !skb_queue_empty(&priv->tx_queue))
+            return -EBUSY;
+    } else {
+        // System sleep: no transmissions until resume
+        netif_device_detach(priv->net_dev);
     }
 
+    rtl8811au_quiesce(priv);
+    priv->suspend_auto = PMSG_IS_AUTO(message);
+    priv->suspend_time = ktime_get();
+    WRITE_ONCE(priv->suspended, true);
 
-    // Release firmware
-    if (priv->firmware) {
-        release_firmware(priv->firmware);
-        priv->firmware = NULL;
+    spin_lock_irqsave(&priv->stats_lock, flags);
+    priv->ext_stats.pm_suspends++;
+    spin_unlock_irqrestore(&priv->stats_lock, flags);
+    return 0;
+}
+
+// Adapt the autosuspend delay to the traffic seen. Waking up within one delay of
+// suspending means the idle gap did not pay for the suspend/resume round trip, so the
+// delay doubles; sleeping for many delays means traffic is sparse and it halves.
+static void rtl8811au_adapt_autosuspend(struct rtl8811au_dev *priv) {
+    s64 slept_ms = ktime_ms_delta(ktime_get(), priv->suspend_time);
+    unsigned int ms = priv->autosuspend_ms;
+    unsigned long flags;
+    bool premature = false;
+
+    if (slept_ms < ms) {
+        ms = min(ms * 2, (unsigned int)RTL8811AU_AUTOSUSPEND_MAX_MS);
+        premature = true;
+    } else if (slept_ms > 10LL * ms) {
+        ms = max(ms / 2, (unsigned int)RTL8811AU_AUTOSUSPEND_MIN_MS);
     }
 
-    // Cleanup remaining USB resources
-    usb_set_intfdata(interface, NULL); // Clear association
-    if (priv->usb_dev) {
-        usb_put_dev(priv->usb_dev); // Decrement refcount taken in probe
-        priv->usb_dev = NULL;
+    spin_lock_irqsave(&priv->stats_lock, flags);
+    if (premature)
+        priv->ext_stats.pm_premature_wakes++;
+    priv->ext_stats.pm_autosuspend_ms = ms;
+    spin_unlock_irqrestore(&priv->stats_lock, flags);
+
+    if (ms != priv->autosuspend_ms) {
+        WRITE_ONCE(priv->autosuspend_ms, ms);
+        // Changing the delay from inside a PM callback would re-enter the PM core
+        queue_work(priv->wq, &priv->autosuspend_work);
     }
+}
+
+static int rtl8811au_resume(struct usb_interface *interface) {
+    struct rtl8811au_dev *priv = usb_get_intfdata(interface);
+    ktime_t start = ktime_get();
+    unsigned long flags;
+    int ret;
+    u64 us;
 
-    // devm_kzalloc'd memory (band, channels, rates, main priv) is freed automatically
+    if (!priv || !priv->net_dev)
+        return 0;
 
-    printk(KERN_INFO "rtl8811au_wifi: Device disconnected\n");
+    if (priv->suspend_auto)
+        rtl8811au_adapt_autosuspend(priv);
+
+    ret = rtl8811au_restore(priv);
+    WRITE_ONCE(priv->suspended, false);
+    if (ret)
+        return ret;
+    netif_device_attach(priv->net_dev);
+
+    us = ktime_us_delta(ktime_get(), start);
+    spin_lock_irqsave(&priv->stats_lock, flags);
+    priv->ext_stats.pm_resumes++;
+    priv->ext_stats.pm_resume_last_us = us;
+    priv->ext_stats.pm_resume_max_us = max(priv->ext_stats.pm_resume_max_us, us);
+    spin_unlock_irqrestore(&priv->stats_lock, flags);
+    return 0;
+}
+
+// The device was reset or lost power while suspended: same restore, the shadow
+// rewrite is forced either way
+static int rtl8811au_reset_resume(struct usb_interface *interface) {
+    return rtl8811au_resume(interface);
 }
 
 // --- USB Driver ---
@@ -893,9 +3372,12 @@ static struct usb_driver rtl8811au_driver = {
     .id_table = rtl8811au_table, // USB IDs it supports
     .probe = rtl8811au_probe, // Probe function
     .disconnect = rtl8811au_disconnect, // Disconnect function
-    // Add suspend/resume handlers if power management is needed
-    // .suspend = rtl8811au_suspend,
-    // .resume = rtl8811au_resume,
+    .pre_reset = rtl8811au_pre_reset, // Quiesce I/O before a port reset
+    .post_reset = rtl8811au_post_reset, // Reprogram and restart after it
+    .suspend = rtl8811au_suspend,
+    .resume = rtl8811au_resume,
+    .reset_resume = rtl8811au_reset_resume,
+    .supports_autosuspend = 1,
 };
 
 // --- Module Init/Exit ---
@@ -920,6 +3402,12 @@ static void __exit rtl8811au_exit(void) {
 module_init(rtl8811au_init);
 module_exit(rtl8811au_exit);
 
+// KUnit suite, built in here so it can drive the static handlers directly. Only test
+// kernels set CONFIG_RTL8811AU_KUNIT_TEST (see Kconfig and `make kunit`).
+#if IS_ENABLED(CONFIG_RTL8811AU_KUNIT_TEST)
+#include "rtl8811au_test.c"
+#endif
+
 MODULE_LICENSE("GPL");
 MODULE_AUTHOR("pseudo-software-inc (with fixes by AI)");
 MODULE_DESCRIPTION("Basic RTL8811AU Wi-Fi USB driver skeleton");
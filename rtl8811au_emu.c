@@ -0,0 +1,1192 @@
+// Emulated RTL8811AU for hardware-free testing and benchmarking.
+//
+// A USB function ("rtl8811au" in gadget configfs) with one vendor interface holding a
+// bulk-in and a bulk-out endpoint, as rtl8811au_probe() expects. Each function instance
+// is one adapter: put it in a gadget with the TP-Link AC600 IDs (0x2357:0x011e), bind
+// the gadget to a UDC (dummy_hcd gives virtual ones on any box) and rtl8811au binds to
+// it like to the real adapter. rtl8811au-emu.sh does the configfs part:
+//
+//   modprobe dummy_hcd num=4
+//   insmod rtl8811au_emu.ko
+//   ./rtl8811au-emu.sh create 4
+//   insmod rtl8811au.ko
+//
+// Behaviour of the emulated chip:
+//  - Vendor request 0x05 reads and writes a register file. RCR, MACID and MAR act as the
+//    hardware RX filter does.
+//  - Bulk-out transfers are parsed as TX descriptors (honouring USB aggregation). Each
+//    frame is turned into a From-DS frame and looped back on bulk-in with an RX
+//    descriptor, PHY status and FCS, packed 8-byte aligned like USB RX aggregation.
+//  - Rates, latency and error injection (-EPIPE via endpoint halts, NAK stalls, CRC
+//    errors) are module parameters shared by every adapter and can be changed at
+//    runtime under /sys/module/rtl8811au_emu/parameters/.
+//  - Counters are per adapter in /sys/kernel/debug/rtl8811au_emu/<instance>/stats.
+//
+// The descriptor layouts below must match rtl8811au.c.
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/usb/composite.h>
+#include <linux/usb/gadget.h>
+#include <linux/ieee80211.h>
+#include <linux/etherdevice.h>
+#include <linux/if_ether.h>
+#include <linux/ip.h>
+#include <linux/icmp.h>
+#include <linux/spinlock.h>
+#include <linux/mutex.h>
+#include <linux/slab.h>
+#include <linux/hrtimer.h>
+#include <linux/ktime.h>
+#include <linux/bitfield.h>
+#include <linux/build_bug.h>
+#include <linux/crc32.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <net/checksum.h>
+
+#define EMU_NUM_REQS 8          // Requests per endpoint, matching the host's RX URB pool
+#define EMU_BUF_SIZE 65536      // Largest transfer in either direction
+#define EMU_FLOOD_TICK_US 250   // RX flood generator period
+#define EMU_FLOOD_MAX_LEN 9000  // Ethernet payload limit for flood frames
+#define EMU_BUCKET_BURST 64     // Frames a rate limiter may pass back to back
+
+// --- Register Interface ---
+#define EMU_USB_REQ_VENDOR 0x05
+#define EMU_REG_SPACE 0x1000
+
+#define REG_RCR                 0x0608
+#define REG_MACID               0x0610
+#define REG_BSSID               0x0618
+#define REG_MAR                 0x0620
+
+#define RCR_AAP                 BIT(0)
+#define RCR_APM                 BIT(1)
+#define RCR_AM                  BIT(2)
+#define RCR_AB                  BIT(3)
+
+// --- Descriptor Layouts (see rtl8811au.c) ---
+#define EMU_TX_DESC_SIZE 40
+#define EMU_RX_DESC_SIZE 24
+#define EMU_AGG_ALIGN 8
+
+#define TX_DESC_DW0_PKT_SIZE    GENMASK(15, 0)
+#define TX_DESC_DW0_OFFSET      GENMASK(23, 16)
+#define TX_DESC_DW0_OWN         BIT(31)
+
+#define RX_DESC_DW0_PKT_LEN     GENMASK(13, 0)
+#define RX_DESC_DW0_CRC32       BIT(14)
+#define RX_DESC_DW0_DRVINFO_SZ  GENMASK(19, 16)
+#define RX_DESC_DW0_PHYST       BIT(26)
+#define RX_DESC_DW3_RX_RATE     GENMASK(6, 0)
+
+struct emu_rx_desc {
+    __le32 dw0;
+    __le32 dw1;
+    __le32 dw2;
+    __le32 dw3;
+    __le32 dw4;
+    __le32 dw5;             // TSF low
+} __packed;
+static_assert(sizeof(struct emu_rx_desc) == EMU_RX_DESC_SIZE);
+
+struct emu_phy_status {
+    u8 gain_trsw[2];
+    __le16 chl_info;        // Channel in bits 9:0
+    u8 pwdb_all;            // 0.5 dB steps offset by 110
+    u8 rsvd[27];
+} __packed;
+static_assert(sizeof(struct emu_phy_status) == 32);
+
+#define EMU_RX_HDR_LEN (sizeof(struct emu_rx_desc) + sizeof(struct emu_phy_status))
+
+// --- Module Parameters ---
+static bool loop = true;
+module_param(loop, bool, 0644);
+MODULE_PARM_DESC(loop, "Loop TX frames back as RX (default: true)");
+
+static bool reflect = true;
+module_param(reflect, bool, 0644);
+MODULE_PARM_DESC(reflect, "Swap addresses of looped frames and answer IPv4 ping (default: true)");
+
+static unsigned int loop_pps;
+module_param(loop_pps, uint, 0644);
+MODULE_PARM_DESC(loop_pps, "Rate limit for looped frames in frames/s, excess is dropped (default: 0 = none)");
+
+static unsigned int latency_us;
+module_param(latency_us, uint, 0644);
+MODULE_PARM_DESC(latency_us, "Delay before an RX transfer is handed to the host (default: 0)");
+
+static unsigned int rx_agg_max = 8192;
+module_param(rx_agg_max, uint, 0644);
+MODULE_PARM_DESC(rx_agg_max, "Largest aggregated bulk-in transfer in bytes (default: 8192)");
+
+static unsigned int rx_flood_pps; // module_param_cb below
+MODULE_PARM_DESC(rx_flood_pps, "Generate RX frames to the programmed MAC address at this rate (default: 0 = off)");
+
+static unsigned int rx_flood_len = 64;
+module_param(rx_flood_len, uint, 0644);
+MODULE_PARM_DESC(rx_flood_len, "Payload bytes of generated RX frames (default: 64)");
+
+static int rssi = -40;
+module_param(rssi, int, 0644);
+MODULE_PARM_DESC(rssi, "Signal reported in the PHY status, dBm (default: -40)");
+
+static unsigned int rx_rate = 11;
+module_param(rx_rate, uint, 0644);
+MODULE_PARM_DESC(rx_rate, "Hardware rate index reported in RX descriptors (default: 11 = OFDM 54M)");
+
+static unsigned int channel = 6;
+module_param(channel, uint, 0644);
+MODULE_PARM_DESC(channel, "Channel reported in the PHY status (default: 6)");
+
+static unsigned int crc_every;
+module_param(crc_every, uint, 0644);
+MODULE_PARM_DESC(crc_every, "Flag every Nth RX frame with a CRC error (default: 0 = never)");
+
+static unsigned int in_stall_every;
+module_param(in_stall_every, uint, 0644);
+MODULE_PARM_DESC(in_stall_every, "Halt bulk-in before every Nth RX transfer, host sees -EPIPE (default: 0 = never)");
+
+static unsigned int out_stall_every;
+module_param(out_stall_every, uint, 0644);
+MODULE_PARM_DESC(out_stall_every, "Halt bulk-out after every Nth TX transfer, host sees -EPIPE (default: 0 = never)");
+
+static unsigned int out_nak_every;
+module_param(out_nak_every, uint, 0644);
+MODULE_PARM_DESC(out_nak_every, "Stop accepting TX data after every Nth TX transfer (default: 0 = never)");
+
+static unsigned int out_nak_ms = 6000;
+module_param(out_nak_ms, uint, 0644);
+MODULE_PARM_DESC(out_nak_ms, "How long bulk-out NAKs after out_nak_every triggers (default: 6000)");
+
+// --- Device State ---
+struct rtl8811au_emu_stats {
+    u64 out_xfers;          // Bulk-out transfers received
+    u64 out_bytes;
+    u64 out_errors;
+    u64 out_stalls;         // Injected bulk-out halts
+    u64 out_naks;           // Injected NAK periods
+    u64 tx_frames;          // Frames parsed from bulk-out transfers
+    u64 tx_desc_err;        // Malformed TX descriptors; rest of the transfer discarded
+    u64 tx_csum_err;        // TX descriptor checksum mismatches (frame dropped)
+    u64 tx_non_data;        // Management/control frames, not looped
+    u64 in_xfers;           // Bulk-in transfers completed
+    u64 in_bytes;
+    u64 in_errors;
+    u64 in_stalls;          // Injected bulk-in halts
+    u64 rx_frames;          // Frames handed to the host
+    u64 rx_flood_frames;    // ... of which generated by the flood
+    u64 rx_filtered;        // Dropped by the RCR/MACID/MAR filter
+    u64 rx_rate_drops;      // Dropped by loop_pps
+    u64 rx_overruns;        // Dropped because every bulk-in buffer was in use
+    u64 rx_crc_injected;
+    u64 reg_reads;
+    u64 reg_writes;
+    u64 remote_wakeups;
+};
+
+struct rtl8811au_emu;
+
+struct rtl8811au_emu_req {
+    struct rtl8811au_emu *emu;
+    struct usb_request *req;
+    struct list_head list;
+    unsigned int len;       // Bytes filled so far (IN)
+    ktime_t due;            // When the transfer may be queued (IN)
+};
+
+// Token bucket for the rate limits, in frame-nanoseconds
+struct emu_bucket {
+    ktime_t last;
+    u64 credit;
+};
+
+struct rtl8811au_emu {
+    struct usb_function func;
+    struct list_head node;                  // On emu_list
+    struct dentry *debugfs;
+    struct usb_ep *in_ep;
+    struct usb_ep *out_ep;
+    struct rtl8811au_emu_req in_reqs[EMU_NUM_REQS];
+    struct rtl8811au_emu_req out_reqs[EMU_NUM_REQS];
+
+    spinlock_t lock;                        // Everything below; taken before the UDC's lock
+    bool online;                            // Interface configured, endpoints enabled
+    bool suspended;
+    bool wakeup_sent;
+    struct list_head in_free;               // IN requests available for filling
+    struct list_head in_ready;              // Filled IN requests waiting for their due time
+    struct rtl8811au_emu_req *in_fill;      // IN request being filled
+    struct list_head out_held;              // OUT requests held back while NAKing
+    ktime_t nak_until;
+    bool in_stall_pending;
+    unsigned int in_seq, out_seq, rx_seq;   // Counters for the *_every injections
+    struct emu_bucket loop_bucket;
+    struct emu_bucket flood_bucket;
+    struct hrtimer timer;                   // Latency release, flood, end of NAK period
+    ktime_t timer_next;                     // Programmed expiry, KTIME_MAX when idle
+    u16 reg_addr;                           // Target of the control write in progress
+    u8 regs[EMU_REG_SPACE];
+    struct rtl8811au_emu_stats stats;
+};
+
+// Function instance, functions/rtl8811au.<name> in configfs
+struct rtl8811au_emu_opts {
+    struct usb_function_instance func_inst;
+    char name[32];                          // Instance name, also the debugfs directory
+};
+
+static struct dentry *emu_debugfs;          // rtl8811au_emu/, one directory per adapter
+static LIST_HEAD(emu_list);                 // Every allocated adapter
+static DEFINE_SPINLOCK(emu_list_lock);      // Taken before emu->lock
+static DEFINE_MUTEX(emu_desc_mutex);        // Descriptor templates are patched in bind
+
+// Source address of generated frames (locally administered)
+static const u8 emu_flood_sa[ETH_ALEN] = { 0x02, 0x88, 0x11, 0xa0, 0x00, 0x01 };
+
+static inline struct rtl8811au_emu *func_to_emu(struct usb_function *f) {
+    return container_of(f, struct rtl8811au_emu, func);
+}
+
+static u32 emu_reg32(const struct rtl8811au_emu *emu, u16 addr) {
+    __le32 v;
+
+    memcpy(&v, &emu->regs[addr], sizeof(v));
+    return le32_to_cpu(v);
+}
+
+// --- Timer and Rate Limits ---
+// Called with emu->lock held. The callback never restarts itself; everything that
+// creates a future event arms the timer through here.
+static void emu_arm(struct rtl8811au_emu *emu, ktime_t when) {
+    if (when >= emu->timer_next)
+        return;
+    emu->timer_next = when;
+    hrtimer_start(&emu->timer, when, HRTIMER_MODE_ABS);
+}
+
+static unsigned int emu_bucket_take(struct emu_bucket *b, unsigned int pps, ktime_t now,
+                                    unsigned int want) {
+    u64 elapsed = min_t(u64, ktime_to_ns(ktime_sub(now, b->last)), NSEC_PER_SEC);
+    u64 cap = (u64)max(pps / 100, (unsigned int)EMU_BUCKET_BURST) * NSEC_PER_SEC;
+    unsigned int got;
+
+    b->last = now;
+    b->credit = min(b->credit + elapsed * pps, cap);
+    got = min_t(u64, want, div_u64(b->credit, NSEC_PER_SEC));
+    b->credit -= (u64)got * NSEC_PER_SEC;
+    return got;
+}
+
+// --- Bulk-In (RX) ---
+// Hand a filled buffer over for release after latency_us
+static void emu_in_close(struct rtl8811au_emu *emu, ktime_t now) {
+    struct rtl8811au_emu_req *er = emu->in_fill;
+
+    if (!er)
+        return;
+    emu->in_fill = NULL;
+    er->due = ktime_add_us(now, READ_ONCE(latency_us));
+    list_add_tail(&er->list, &emu->in_ready);
+    if (er->due > now)
+        emu_arm(emu, er->due); // Otherwise the caller releases it right away
+}
+
+// Queue every ready buffer whose due time has passed, in order
+static void emu_in_release(struct rtl8811au_emu *emu, ktime_t now) {
+    struct rtl8811au_emu_req *er;
+    unsigned int every;
+    int ret;
+
+    if (emu->suspended) {
+        // Data is waiting: signal remote wakeup once per suspend
+        if (!list_empty(&emu->in_ready) && !emu->wakeup_sent &&
+            !usb_gadget_wakeup(emu->func.config->cdev->gadget)) {
+            emu->wakeup_sent = true;
+            emu->stats.remote_wakeups++;
+        }
+        return;
+    }
+
+    while (!list_empty(&emu->in_ready)) {
+        er = list_first_entry(&emu->in_ready, struct rtl8811au_emu_req, list);
+        if (er->due > now)
+            break;
+
+        every = READ_ONCE(in_stall_every);
+        if (every && ++emu->in_seq % every == 0)
+            emu->in_stall_pending = true;
+        // An IN endpoint can only be halted with nothing queued on it
+        if (emu->in_stall_pending && !usb_ep_set_halt(emu->in_ep)) {
+            emu->in_stall_pending = false;
+            emu->stats.in_stalls++;
+        }
+
+        list_del(&er->list);
+        er->req->length = er->len;
+        er->req->zero = 0;
+        ret = usb_ep_queue(emu->in_ep, er->req, GFP_ATOMIC);
+        if (ret) {
+            emu->stats.in_errors++;
+            er->len = 0;
+            list_add_tail(&er->list, &emu->in_free);
+        }
+    }
+}
+
+// Reserve room for one frame of pkt_len bytes (802.11 header to FCS) in the buffer being
+// filled and write its RX descriptor and PHY status. Returns where the 802.11 frame goes,
+// or NULL if every buffer is in use.
+static u8 *emu_rx_alloc(struct rtl8811au_emu *emu, unsigned int pkt_len, ktime_t now) {
+    unsigned int need = EMU_RX_HDR_LEN + pkt_len;
+    unsigned int limit = clamp_t(unsigned int, READ_ONCE(rx_agg_max), 512, EMU_BUF_SIZE);
+    struct rtl8811au_emu_req *er = emu->in_fill;
+    struct emu_phy_status *phy;
+    struct emu_rx_desc *desc;
+    unsigned int start;
+    u8 *buf;
+    int pwdb;
+
+    if (need > EMU_BUF_SIZE)
+        return NULL;
+    limit = max(limit, need); // A frame larger than the aggregation limit goes alone
+
+    if (er && ALIGN(er->len, EMU_AGG_ALIGN) + need > limit) {
+        emu_in_close(emu, now);
+        er = NULL;
+    }
+    if (!er) {
+        if (list_empty(&emu->in_free))
+            return NULL;
+        er = list_first_entry(&emu->in_free, struct rtl8811au_emu_req, list);
+        list_del(&er->list);
+        er->len = 0;
+        emu->in_fill = er;
+    }
+
+    buf = er->req->buf;
+    start = ALIGN(er->len, EMU_AGG_ALIGN);
+    memset(buf + er->len, 0, start - er->len);
+    er->len = start + need;
+
+    desc = (struct emu_rx_desc *)(buf + start);
+    desc->dw0 = cpu_to_le32(FIELD_PREP(RX_DESC_DW0_PKT_LEN, pkt_len) |
+                            FIELD_PREP(RX_DESC_DW0_DRVINFO_SZ, sizeof(*phy) / 8) |
+                            RX_DESC_DW0_PHYST);
+    desc->dw1 = 0;
+    desc->dw2 = 0;
+    desc->dw3 = cpu_to_le32(FIELD_PREP(RX_DESC_DW3_RX_RATE, READ_ONCE(rx_rate)));
+    desc->dw4 = 0;
+    desc->dw5 = cpu_to_le32(lower_32_bits(ktime_to_us(now)));
+
+    phy = (struct emu_phy_status *)(desc + 1);
+    memset(phy, 0, sizeof(*phy));
+    phy->chl_info = cpu_to_le16(READ_ONCE(channel) & 0x3ff);
+    pwdb = (READ_ONCE(rssi) + 110) * 2;
+    phy->pwdb_all = clamp(pwdb, 0, 255);
+
+    if (READ_ONCE(crc_every) && ++emu->rx_seq % READ_ONCE(crc_every) == 0) {
+        desc->dw0 |= cpu_to_le32(RX_DESC_DW0_CRC32);
+        emu->stats.rx_crc_injected++;
+    }
+    emu->stats.rx_frames++;
+    return (u8 *)(phy + 1);
+}
+
+static void emu_rx_fcs(u8 *frame, unsigned int len) {
+    __le32 fcs = cpu_to_le32(~crc32_le(~0, frame, len));
+
+    memcpy(frame + len, &fcs, FCS_LEN);
+}
+
+// What RCR, MACID and MAR let through
+static bool emu_rx_accept(const struct rtl8811au_emu *emu, const u8 *da) {
+    u32 rcr = emu_reg32(emu, REG_RCR);
+    u32 bit;
+
+    if (is_broadcast_ether_addr(da))
+        return rcr & RCR_AB;
+    if (is_multicast_ether_addr(da)) {
+        bit = ether_crc(ETH_ALEN, da) >> 26;
+        return (rcr & RCR_AM) && (emu->regs[REG_MAR + (bit >> 3)] & BIT(bit & 7));
+    }
+    return (rcr & RCR_AAP) || ((rcr & RCR_APM) && ether_addr_equal(da, &emu->regs[REG_MACID]));
+}
+
+// Turn an IPv4 ICMP echo request into the reply, so ping works through the loop
+static void emu_reflect_ip(u8 *body, unsigned int len) {
+    const __be16 ip_proto = htons(ETH_P_IP);
+    struct icmphdr *icmp;
+    struct iphdr *iph;
+    unsigned int ihl;
+    __be32 addr;
+
+    if (len < sizeof(rfc1042_header) + 2 + sizeof(*iph) ||
+        memcmp(body, rfc1042_header, sizeof(rfc1042_header)) ||
+        memcmp(body + sizeof(rfc1042_header), &ip_proto, 2))
+        return;
+    body += sizeof(rfc1042_header) + 2;
+    len -= sizeof(rfc1042_header) + 2;
+
+    iph = (struct iphdr *)body;
+    ihl = iph->ihl * 4;
+    if (iph->version != 4 || ihl < sizeof(*iph) || len < ihl)
+        return;
+    // Swapping the addresses leaves the header checksum unchanged
+    addr = iph->saddr;
+    iph->saddr = iph->daddr;
+    iph->daddr = addr;
+
+    if (iph->protocol != IPPROTO_ICMP || len < ihl + sizeof(*icmp))
+        return;
+    icmp = (struct icmphdr *)(body + ihl);
+    if (icmp->type != ICMP_ECHO)
+        return;
+    icmp->type = ICMP_ECHOREPLY;
+    csum_replace2(&icmp->checksum, htons(ICMP_ECHO << 8), htons(ICMP_ECHOREPLY << 8));
+}
+
+// Loop one TX frame back as the From-DS frame the AP would deliver
+static void emu_loop_frame(struct rtl8811au_emu *emu, const u8 *frame, unsigned int len, ktime_t now) {
+    const struct ieee80211_hdr *hdr = (const struct ieee80211_hdr *)frame;
+    const u8 *da, *sa, *bssid;
+    struct ieee80211_hdr *out;
+    unsigned int hdrlen;
+    unsigned int pps;
+    __le16 fc;
+
+    if (len < sizeof(struct ieee80211_hdr_3addr)) {
+        emu->stats.tx_desc_err++;
+        return;
+    }
+    fc = hdr->frame_control;
+    if (!ieee80211_is_data(fc) || ieee80211_has_a4(fc)) {
+        emu->stats.tx_non_data++;
+        return;
+    }
+    hdrlen = ieee80211_hdrlen(fc);
+    if (len < hdrlen) {
+        emu->stats.tx_desc_err++;
+        return;
+    }
+
+    da = ieee80211_get_DA((struct ieee80211_hdr *)hdr);
+    sa = ieee80211_get_SA((struct ieee80211_hdr *)hdr);
+    bssid = ieee80211_has_tods(fc) ? hdr->addr1 : hdr->addr3;
+    if (READ_ONCE(reflect) && !is_multicast_ether_addr(da))
+        swap(da, sa);
+
+    if (!emu_rx_accept(emu, da)) {
+        emu->stats.rx_filtered++;
+        return;
+    }
+    pps = READ_ONCE(loop_pps);
+    if (pps && !emu_bucket_take(&emu->loop_bucket, pps, now, 1)) {
+        emu->stats.rx_rate_drops++;
+        return;
+    }
+
+    out = (struct ieee80211_hdr *)emu_rx_alloc(emu, len + FCS_LEN, now);
+    if (!out) {
+        emu->stats.rx_overruns++;
+        return;
+    }
+    memcpy(out, frame, len);
+    out->frame_control = (fc & ~cpu_to_le16(IEEE80211_FCTL_TODS)) | cpu_to_le16(IEEE80211_FCTL_FROMDS);
+    memcpy(out->addr1, da, ETH_ALEN);
+    memcpy(out->addr2, bssid, ETH_ALEN);
+    memcpy(out->addr3, sa, ETH_ALEN);
+    if (READ_ONCE(reflect))
+        emu_reflect_ip((u8 *)out + hdrlen, len - hdrlen);
+    emu_rx_fcs((u8 *)out, len);
+}
+
+// Walk the TX descriptors of one bulk-out transfer
+static void emu_loop_transfer(struct rtl8811au_emu *emu, const u8 *buf, unsigned int len, ktime_t now) {
+    const __le16 *word;
+    unsigned int offset = 0;
+    unsigned int pkt, hdr;
+    u16 csum;
+    u32 dw0;
+    int i;
+
+    while (offset + EMU_TX_DESC_SIZE <= len) {
+        dw0 = le32_to_cpu(*(const __le32 *)(buf + offset));
+        pkt = FIELD_GET(TX_DESC_DW0_PKT_SIZE, dw0);
+        hdr = FIELD_GET(TX_DESC_DW0_OFFSET, dw0);
+        if (!(dw0 & TX_DESC_DW0_OWN) || hdr < EMU_TX_DESC_SIZE || offset + hdr + pkt > len) {
+            emu->stats.tx_desc_err++;
+            return;
+        }
+        emu->stats.tx_frames++;
+
+        // XOR of the first 16 words, checksum included, is zero for a good descriptor
+        word = (const __le16 *)(buf + offset);
+        for (csum = 0, i = 0; i < 16; i++)
+            csum ^= le16_to_cpu(word[i]);
+        if (csum)
+            emu->stats.tx_csum_err++;
+        else if (READ_ONCE(loop))
+            emu_loop_frame(emu, buf + offset + hdr, pkt, now);
+
+        offset = ALIGN(offset + hdr + pkt, EMU_AGG_ALIGN);
+    }
+}
+
+// Generate rx_flood_pps frames per second addressed to the programmed MAC. The
+// EtherType is local-experimental, so the host stack counts and drops them.
+static void emu_flood(struct rtl8811au_emu *emu, ktime_t now) {
+    unsigned int pps = READ_ONCE(rx_flood_pps);
+    unsigned int body = min(READ_ONCE(rx_flood_len), (unsigned int)EMU_FLOOD_MAX_LEN);
+    unsigned int len = sizeof(struct ieee80211_hdr_3addr) + sizeof(rfc1042_header) + 2 + body;
+    struct ieee80211_hdr_3addr *hdr;
+    unsigned int n;
+    __be16 proto = htons(ETH_P_802_EX1);
+    u8 *p;
+
+    if (!pps) {
+        emu->flood_bucket.last = now;
+        emu->flood_bucket.credit = 0;
+        return;
+    }
+
+    for (n = emu_bucket_take(&emu->flood_bucket, pps, now, UINT_MAX); n; n--) {
+        p = emu_rx_alloc(emu, len + FCS_LEN, now);
+        if (!p) {
+            emu->stats.rx_overruns += n;
+            break;
+        }
+        hdr = (struct ieee80211_hdr_3addr *)p;
+        memset(hdr, 0, sizeof(*hdr));
+        hdr->frame_control = cpu_to_le16(IEEE80211_FTYPE_DATA | IEEE80211_STYPE_DATA |
+                                         IEEE80211_FCTL_FROMDS);
+        memcpy(hdr->addr1, &emu->regs[REG_MACID], ETH_ALEN);
+        if (is_zero_ether_addr(hdr->addr1))
+            eth_broadcast_addr(hdr->addr1);
+        memcpy(hdr->addr2, &emu->regs[REG_BSSID], ETH_ALEN);
+        memcpy(hdr->addr3, emu_flood_sa, ETH_ALEN);
+        hdr->seq_ctrl = cpu_to_le16(IEEE80211_SN_TO_SEQ(emu->stats.rx_flood_frames));
+        p += sizeof(*hdr);
+        memcpy(p, rfc1042_header, sizeof(rfc1042_header));
+        memcpy(p + sizeof(rfc1042_header), &proto, 2);
+        memset(p + sizeof(rfc1042_header) + 2, 0, body);
+        emu_rx_fcs((u8 *)hdr, len);
+        emu->stats.rx_flood_frames++;
+    }
+    emu_in_close(emu, now);
+}
+
+static void emu_in_complete(struct usb_ep *ep, struct usb_request *req) {
+    struct rtl8811au_emu_req *er = req->context;
+    struct rtl8811au_emu *emu = er->emu;
+    unsigned long flags;
+
+    spin_lock_irqsave(&emu->lock, flags);
+    if (req->status == 0) {
+        emu->stats.in_xfers++;
+        emu->stats.in_bytes += req->actual;
+    } else if (req->status != -ESHUTDOWN && req->status != -ECONNRESET) {
+        emu->stats.in_errors++;
+    }
+    er->len = 0;
+    list_add_tail(&er->list, &emu->in_free);
+    spin_unlock_irqrestore(&emu->lock, flags);
+}
+
+// --- Bulk-Out (TX) ---
+static void emu_out_complete(struct usb_ep *ep, struct usb_request *req) {
+    struct rtl8811au_emu_req *er = req->context;
+    struct rtl8811au_emu *emu = er->emu;
+    unsigned long flags;
+    unsigned int every;
+    bool stall = false;
+    ktime_t now;
+
+    if (req->status == -ESHUTDOWN || req->status == -ECONNRESET || req->status == -ECONNABORTED)
+        return; // Endpoint going away; set_alt queues the request again
+
+    spin_lock_irqsave(&emu->lock, flags);
+    now = ktime_get();
+    if (req->status) {
+        emu->stats.out_errors++;
+    } else {
+        emu->stats.out_xfers++;
+        emu->stats.out_bytes += req->actual;
+        emu_loop_transfer(emu, req->buf, req->actual, now);
+        emu_in_close(emu, now);
+        emu_in_release(emu, now);
+
+        every = READ_ONCE(out_nak_every);
+        if (every && ++emu->out_seq % every == 0) {
+            emu->nak_until = ktime_add_ms(now, READ_ONCE(out_nak_ms));
+            emu->stats.out_naks++;
+            emu_arm(emu, emu->nak_until);
+        }
+        every = READ_ONCE(out_stall_every);
+        stall = every && emu->stats.out_xfers % every == 0;
+    }
+
+    if (!emu->online) {
+        spin_unlock_irqrestore(&emu->lock, flags);
+        return;
+    }
+    if (now < emu->nak_until) {
+        // Not queueing the request makes the UDC NAK the host once all are held
+        list_add_tail(&er->list, &emu->out_held);
+    } else {
+        if (stall && !usb_ep_set_halt(ep))
+            emu->stats.out_stalls++;
+        req->length = EMU_BUF_SIZE;
+        if (usb_ep_queue(ep, req, GFP_ATOMIC))
+            emu->stats.out_errors++;
+    }
+    spin_unlock_irqrestore(&emu->lock, flags);
+}
+
+static enum hrtimer_restart emu_timer(struct hrtimer *timer) {
+    struct rtl8811au_emu *emu = container_of(timer, struct rtl8811au_emu, timer);
+    struct rtl8811au_emu_req *er, *tmp;
+    unsigned long flags;
+    ktime_t now;
+
+    spin_lock_irqsave(&emu->lock, flags);
+    emu->timer_next = KTIME_MAX;
+    if (!emu->online)
+        goto out;
+    now = ktime_get();
+
+    if (!list_empty(&emu->out_held)) {
+        if (now >= emu->nak_until) {
+            list_for_each_entry_safe(er, tmp, &emu->out_held, list) {
+                list_del(&er->list);
+                er->req->length = EMU_BUF_SIZE;
+                if (usb_ep_queue(emu->out_ep, er->req, GFP_ATOMIC))
+                    emu->stats.out_errors++;
+            }
+        } else {
+            emu_arm(emu, emu->nak_until);
+        }
+    }
+
+    emu_flood(emu, now);
+    emu_in_release(emu, now);
+
+    if (!list_empty(&emu->in_ready) && !emu->suspended) {
+        er = list_first_entry(&emu->in_ready, struct rtl8811au_emu_req, list);
+        emu_arm(emu, er->due);
+    }
+    if (READ_ONCE(rx_flood_pps))
+        emu_arm(emu, ktime_add_us(now, EMU_FLOOD_TICK_US));
+out:
+    spin_unlock_irqrestore(&emu->lock, flags);
+    return HRTIMER_NORESTART;
+}
+
+// Module parameters are read on every use; starting the flood needs a timer kick on
+// every adapter
+static int emu_flood_set(const char *val, const struct kernel_param *kp) {
+    struct rtl8811au_emu *emu;
+    unsigned long flags;
+    int ret;
+
+    ret = param_set_uint(val, kp);
+    if (ret)
+        return ret;
+    spin_lock_irqsave(&emu_list_lock, flags);
+    list_for_each_entry(emu, &emu_list, node) {
+        spin_lock(&emu->lock);
+        if (emu->online && rx_flood_pps)
+            emu_arm(emu, ktime_get());
+        spin_unlock(&emu->lock);
+    }
+    spin_unlock_irqrestore(&emu_list_lock, flags);
+    return 0;
+}
+
+static const struct kernel_param_ops emu_flood_ops = {
+    .set = emu_flood_set,
+    .get = param_get_uint,
+};
+module_param_cb(rx_flood_pps, &emu_flood_ops, &rx_flood_pps, 0644);
+
+// --- Control Requests ---
+static void emu_reg_write_complete(struct usb_ep *ep, struct usb_request *req) {
+    struct rtl8811au_emu *emu = req->context;
+    unsigned long flags;
+
+    if (req->status || req->actual != req->length)
+        return;
+    spin_lock_irqsave(&emu->lock, flags);
+    memcpy(&emu->regs[emu->reg_addr], req->buf, req->actual);
+    emu->stats.reg_writes++;
+    spin_unlock_irqrestore(&emu->lock, flags);
+}
+
+// Vendor request 0x05: wValue is the register address, the data stage its contents.
+// Composite hands function-specific requests over as they are, so the data/status
+// stage is queued on ep0 here.
+static int emu_setup(struct usb_function *f, const struct usb_ctrlrequest *ctrl) {
+    struct rtl8811au_emu *emu = func_to_emu(f);
+    struct usb_composite_dev *cdev = f->config->cdev;
+    struct usb_request *req = cdev->req;
+    u16 addr = le16_to_cpu(ctrl->wValue);
+    u16 len = le16_to_cpu(ctrl->wLength);
+    unsigned long flags;
+    int ret;
+
+    if ((ctrl->bRequestType & USB_TYPE_MASK) != USB_TYPE_VENDOR ||
+        ctrl->bRequest != EMU_USB_REQ_VENDOR)
+        return -EOPNOTSUPP;
+    if (addr + len > EMU_REG_SPACE || len > USB_COMP_EP0_BUFSIZ)
+        return -EINVAL;
+
+    spin_lock_irqsave(&emu->lock, flags);
+    if (ctrl->bRequestType & USB_DIR_IN) {
+        memcpy(req->buf, &emu->regs[addr], len);
+        emu->stats.reg_reads++;
+    } else {
+        emu->reg_addr = addr;
+        req->context = emu; // ep0 request is shared by the gadget; composite resets it
+        req->complete = emu_reg_write_complete;
+    }
+    spin_unlock_irqrestore(&emu->lock, flags);
+
+    req->length = len;
+    req->zero = 0;
+    ret = usb_ep_queue(cdev->gadget->ep0, req, GFP_ATOMIC);
+    if (ret)
+        ERROR(cdev, "rtl8811au_emu: ep0 queue failed (%d)\n", ret);
+    return ret;
+}
+
+// --- Descriptors ---
+static struct usb_interface_descriptor emu_intf = {
+    .bLength = USB_DT_INTERFACE_SIZE,
+    .bDescriptorType = USB_DT_INTERFACE,
+    .bNumEndpoints = 2,
+    .bInterfaceClass = USB_CLASS_VENDOR_SPEC,
+    .bInterfaceSubClass = 0xff,
+    .bInterfaceProtocol = 0xff,
+};
+
+static struct usb_endpoint_descriptor emu_fs_in_desc = {
+    .bLength = USB_DT_ENDPOINT_SIZE,
+    .bDescriptorType = USB_DT_ENDPOINT,
+    .bEndpointAddress = USB_DIR_IN,
+    .bmAttributes = USB_ENDPOINT_XFER_BULK,
+};
+
+static struct usb_endpoint_descriptor emu_fs_out_desc = {
+    .bLength = USB_DT_ENDPOINT_SIZE,
+    .bDescriptorType = USB_DT_ENDPOINT,
+    .bEndpointAddress = USB_DIR_OUT,
+    .bmAttributes = USB_ENDPOINT_XFER_BULK,
+};
+
+static struct usb_endpoint_descriptor emu_hs_in_desc = {
+    .bLength = USB_DT_ENDPOINT_SIZE,
+    .bDescriptorType = USB_DT_ENDPOINT,
+    .bmAttributes = USB_ENDPOINT_XFER_BULK,
+    .wMaxPacketSize = cpu_to_le16(512),
+};
+
+static struct usb_endpoint_descriptor emu_hs_out_desc = {
+    .bLength = USB_DT_ENDPOINT_SIZE,
+    .bDescriptorType = USB_DT_ENDPOINT,
+    .bmAttributes = USB_ENDPOINT_XFER_BULK,
+    .wMaxPacketSize = cpu_to_le16(512),
+};
+
+static struct usb_endpoint_descriptor emu_ss_in_desc = {
+    .bLength = USB_DT_ENDPOINT_SIZE,
+    .bDescriptorType = USB_DT_ENDPOINT,
+    .bmAttributes = USB_ENDPOINT_XFER_BULK,
+    .wMaxPacketSize = cpu_to_le16(1024),
+};
+
+static struct usb_endpoint_descriptor emu_ss_out_desc = {
+    .bLength = USB_DT_ENDPOINT_SIZE,
+    .bDescriptorType = USB_DT_ENDPOINT,
+    .bmAttributes = USB_ENDPOINT_XFER_BULK,
+    .wMaxPacketSize = cpu_to_le16(1024),
+};
+
+static struct usb_ss_ep_comp_descriptor emu_ss_comp_desc = {
+    .bLength = USB_DT_SS_EP_COMP_SIZE,
+    .bDescriptorType = USB_DT_SS_ENDPOINT_COMP,
+};
+
+static struct usb_descriptor_header *emu_fs_function[] = {
+    (struct usb_descriptor_header *)&emu_intf,
+    (struct usb_descriptor_header *)&emu_fs_in_desc,
+    (struct usb_descriptor_header *)&emu_fs_out_desc,
+    NULL,
+};
+
+static struct usb_descriptor_header *emu_hs_function[] = {
+    (struct usb_descriptor_header *)&emu_intf,
+    (struct usb_descriptor_header *)&emu_hs_in_desc,
+    (struct usb_descriptor_header *)&emu_hs_out_desc,
+    NULL,
+};
+
+static struct usb_descriptor_header *emu_ss_function[] = {
+    (struct usb_descriptor_header *)&emu_intf,
+    (struct usb_descriptor_header *)&emu_ss_in_desc,
+    (struct usb_descriptor_header *)&emu_ss_comp_desc,
+    (struct usb_descriptor_header *)&emu_ss_out_desc,
+    (struct usb_descriptor_header *)&emu_ss_comp_desc,
+    NULL,
+};
+
+// --- Function ---
+static void emu_free_reqs(struct usb_ep *ep, struct rtl8811au_emu_req *reqs) {
+    int i;
+
+    for (i = 0; i < EMU_NUM_REQS; i++) {
+        if (!reqs[i].req)
+            continue;
+        kfree(reqs[i].req->buf);
+        usb_ep_free_request(ep, reqs[i].req);
+        reqs[i].req = NULL;
+    }
+}
+
+static int emu_alloc_reqs(struct rtl8811au_emu *emu, struct usb_ep *ep, struct rtl8811au_emu_req *reqs,
+                          void (*complete)(struct usb_ep *, struct usb_request *)) {
+    struct usb_request *req;
+    int i;
+
+    for (i = 0; i < EMU_NUM_REQS; i++) {
+        req = usb_ep_alloc_request(ep, GFP_KERNEL);
+        if (!req)
+            return -ENOMEM;
+        req->buf = kmalloc(EMU_BUF_SIZE, GFP_KERNEL);
+        if (!req->buf) {
+            usb_ep_free_request(ep, req);
+            return -ENOMEM;
+        }
+        req->complete = complete;
+        req->context = &reqs[i];
+        reqs[i].emu = emu;
+        reqs[i].req = req;
+    }
+    return 0;
+}
+
+static int emu_func_bind(struct usb_configuration *c, struct usb_function *f) {
+    struct usb_composite_dev *cdev = c->cdev;
+    struct rtl8811au_emu *emu = func_to_emu(f);
+    int ret;
+
+    ret = usb_interface_id(c, f);
+    if (ret < 0)
+        return ret;
+
+    // Gadgets on different UDCs bind concurrently; the templates are copied per function
+    mutex_lock(&emu_desc_mutex);
+    emu_intf.bInterfaceNumber = ret;
+    emu->in_ep = usb_ep_autoconfig(cdev->gadget, &emu_fs_in_desc);
+    emu->out_ep = usb_ep_autoconfig(cdev->gadget, &emu_fs_out_desc);
+    if (!emu->in_ep || !emu->out_ep) {
+        mutex_unlock(&emu_desc_mutex);
+        ERROR(cdev, "rtl8811au_emu: no bulk endpoints available\n");
+        return -ENODEV;
+    }
+    emu_hs_in_desc.bEndpointAddress = emu_fs_in_desc.bEndpointAddress;
+    emu_hs_out_desc.bEndpointAddress = emu_fs_out_desc.bEndpointAddress;
+    emu_ss_in_desc.bEndpointAddress = emu_fs_in_desc.bEndpointAddress;
+    emu_ss_out_desc.bEndpointAddress = emu_fs_out_desc.bEndpointAddress;
+
+    ret = usb_assign_descriptors(f, emu_fs_function, emu_hs_function, emu_ss_function, emu_ss_function);
+    mutex_unlock(&emu_desc_mutex);
+    if (ret)
+        return ret;
+
+    ret = emu_alloc_reqs(emu, emu->in_ep, emu->in_reqs, emu_in_complete);
+    if (!ret)
+        ret = emu_alloc_reqs(emu, emu->out_ep, emu->out_reqs, emu_out_complete);
+    if (ret) {
+        emu_free_reqs(emu->in_ep, emu->in_reqs);
+        emu_free_reqs(emu->out_ep, emu->out_reqs);
+        usb_free_all_descriptors(f);
+        return ret;
+    }
+
+    INFO(cdev, "rtl8811au_emu: %s speed, IN %s, OUT %s\n",
+         gadget_is_superspeed(c->cdev->gadget) ? "super" :
+         gadget_is_dualspeed(c->cdev->gadget) ? "dual" : "full",
+         emu->in_ep->name, emu->out_ep->name);
+    return 0;
+}
+
+static void emu_func_unbind(struct usb_configuration *c, struct usb_function *f) {
+    struct rtl8811au_emu *emu = func_to_emu(f);
+
+    hrtimer_cancel(&emu->timer);
+    emu_free_reqs(emu->in_ep, emu->in_reqs);
+    emu_free_reqs(emu->out_ep, emu->out_reqs);
+    usb_free_all_descriptors(f);
+}
+
+static void emu_func_disable(struct usb_function *f) {
+    struct rtl8811au_emu *emu = func_to_emu(f);
+    unsigned long flags;
+    int i;
+
+    spin_lock_irqsave(&emu->lock, flags);
+    if (!emu->online) {
+        spin_unlock_irqrestore(&emu->lock, flags);
+        return;
+    }
+    emu->online = false;
+    spin_unlock_irqrestore(&emu->lock, flags);
+
+    // Completes every queued request with -ESHUTDOWN
+    usb_ep_disable(emu->in_ep);
+    usb_ep_disable(emu->out_ep);
+    hrtimer_try_to_cancel(&emu->timer);
+
+    spin_lock_irqsave(&emu->lock, flags);
+    INIT_LIST_HEAD(&emu->in_free);
+    INIT_LIST_HEAD(&emu->in_ready);
+    INIT_LIST_HEAD(&emu->out_held);
+    for (i = 0; i < EMU_NUM_REQS; i++) {
+        emu->in_reqs[i].len = 0;
+        list_add_tail(&emu->in_reqs[i].list, &emu->in_free);
+    }
+    emu->in_fill = NULL;
+    emu->timer_next = KTIME_MAX;
+    spin_unlock_irqrestore(&emu->lock, flags);
+}
+
+static int emu_func_set_alt(struct usb_function *f, unsigned int intf, unsigned int alt) {
+    struct rtl8811au_emu *emu = func_to_emu(f);
+    struct usb_gadget *gadget = f->config->cdev->gadget;
+    unsigned long flags;
+    ktime_t now;
+    int ret, i;
+
+    if (alt)
+        return -EINVAL;
+    emu_func_disable(f);
+
+    ret = config_ep_by_speed(gadget, f, emu->in_ep);
+    if (!ret)
+        ret = usb_ep_enable(emu->in_ep);
+    if (ret)
+        return ret;
+    ret = config_ep_by_speed(gadget, f, emu->out_ep);
+    if (!ret)
+        ret = usb_ep_enable(emu->out_ep);
+    if (ret) {
+        usb_ep_disable(emu->in_ep);
+        return ret;
+    }
+
+    spin_lock_irqsave(&emu->lock, flags);
+    now = ktime_get();
+    emu->online = true;
+    emu->suspended = false;
+    emu->in_stall_pending = false;
+    emu->nak_until = 0;
+    emu->loop_bucket.last = now;
+    emu->flood_bucket.last = now;
+    for (i = 0; i < EMU_NUM_REQS; i++) {
+        emu->out_reqs[i].req->length = EMU_BUF_SIZE;
+        if (usb_ep_queue(emu->out_ep, emu->out_reqs[i].req, GFP_ATOMIC))
+            emu->stats.out_errors++;
+    }
+    if (rx_flood_pps)
+        emu_arm(emu, now);
+    spin_unlock_irqrestore(&emu->lock, flags);
+    return 0;
+}
+
+static void emu_func_suspend(struct usb_function *f) {
+    struct rtl8811au_emu *emu = func_to_emu(f);
+    unsigned long flags;
+
+    spin_lock_irqsave(&emu->lock, flags);
+    emu->suspended = true;
+    emu->wakeup_sent = false;
+    spin_unlock_irqrestore(&emu->lock, flags);
+}
+
+static void emu_func_resume(struct usb_function *f) {
+    struct rtl8811au_emu *emu = func_to_emu(f);
+    unsigned long flags;
+
+    spin_lock_irqsave(&emu->lock, flags);
+    emu->suspended = false;
+    if (emu->online)
+        emu_arm(emu, ktime_get()); // Deliver what piled up while suspended
+    spin_unlock_irqrestore(&emu->lock, flags);
+}
+
+// --- debugfs ---
+static const struct {
+    const char *name;
+    size_t offset;
+} emu_stats_desc[] = {
+#define EMU_STAT(field) { #field, offsetof(struct rtl8811au_emu_stats, field) }
+    EMU_STAT(out_xfers),
+    EMU_STAT(out_bytes),
+    EMU_STAT(out_errors),
+    EMU_STAT(out_stalls),
+    EMU_STAT(out_naks),
+    EMU_STAT(tx_frames),
+    EMU_STAT(tx_desc_err),
+    EMU_STAT(tx_csum_err),
+    EMU_STAT(tx_non_data),
+    EMU_STAT(in_xfers),
+    EMU_STAT(in_bytes),
+    EMU_STAT(in_errors),
+    EMU_STAT(in_stalls),
+    EMU_STAT(rx_frames),
+    EMU_STAT(rx_flood_frames),
+    EMU_STAT(rx_filtered),
+    EMU_STAT(rx_rate_drops),
+    EMU_STAT(rx_overruns),
+    EMU_STAT(rx_crc_injected),
+    EMU_STAT(reg_reads),
+    EMU_STAT(reg_writes),
+    EMU_STAT(remote_wakeups),
+#undef EMU_STAT
+};
+
+static int emu_stats_show(struct seq_file *m, void *v) {
+    struct rtl8811au_emu *emu = m->private;
+    struct rtl8811au_emu_stats stats;
+    unsigned long flags;
+    int i;
+
+    spin_lock_irqsave(&emu->lock, flags);
+    stats = emu->stats;
+    spin_unlock_irqrestore(&emu->lock, flags);
+
+    for (i = 0; i < ARRAY_SIZE(emu_stats_desc); i++)
+        seq_printf(m, "%s: %llu\n", emu_stats_desc[i].name,
+                   *(u64 *)((u8 *)&stats + emu_stats_desc[i].offset));
+    return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(emu_stats);
+
+// --- Function Instance ---
+// configfs creates an instance for each functions/rtl8811au.<name> directory and a
+// function from it when the instance is linked into a configuration.
+static void emu_func_free(struct usb_function *f) {
+    struct rtl8811au_emu *emu = func_to_emu(f);
+    unsigned long flags;
+
+    spin_lock_irqsave(&emu_list_lock, flags);
+    list_del(&emu->node);
+    spin_unlock_irqrestore(&emu_list_lock, flags);
+
+    debugfs_remove_recursive(emu->debugfs);
+    hrtimer_cancel(&emu->timer);
+    kfree(emu);
+}
+
+static struct usb_function *emu_alloc_func(struct usb_function_instance *fi) {
+    struct rtl8811au_emu_opts *opts = container_of(fi, struct rtl8811au_emu_opts, func_inst);
+    struct rtl8811au_emu *emu;
+    unsigned long flags;
+
+    emu = kzalloc(sizeof(*emu), GFP_KERNEL);
+    if (!emu)
+        return ERR_PTR(-ENOMEM);
+
+    spin_lock_init(&emu->lock);
+    INIT_LIST_HEAD(&emu->in_free);
+    INIT_LIST_HEAD(&emu->in_ready);
+    INIT_LIST_HEAD(&emu->out_held);
+    hrtimer_init(&emu->timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+    emu->timer.function = emu_timer;
+    emu->timer_next = KTIME_MAX;
+
+    emu->func.name = "rtl8811au";
+    emu->func.bind = emu_func_bind;
+    emu->func.unbind = emu_func_unbind;
+    emu->func.set_alt = emu_func_set_alt;
+    emu->func.disable = emu_func_disable;
+    emu->func.setup = emu_setup;
+    emu->func.suspend = emu_func_suspend;
+    emu->func.resume = emu_func_resume;
+    emu->func.free_func = emu_func_free;
+
+    // A duplicate instance name only costs the counters of the second adapter
+    emu->debugfs = debugfs_create_dir(opts->name, emu_debugfs);
+    debugfs_create_file("stats", 0444, emu->debugfs, emu, &emu_stats_fops);
+
+    spin_lock_irqsave(&emu_list_lock, flags);
+    list_add_tail(&emu->node, &emu_list);
+    spin_unlock_irqrestore(&emu_list_lock, flags);
+    return &emu->func;
+}
+
+static void emu_attr_release(struct config_item *item) {
+    struct rtl8811au_emu_opts *opts = container_of(to_config_group(item), struct rtl8811au_emu_opts,
+                                                   func_inst.group);
+
+    usb_put_function_instance(&opts->func_inst);
+}
+
+static struct configfs_item_operations emu_item_ops = {
+    .release = emu_attr_release,
+};
+
+static const struct config_item_type emu_func_type = {
+    .ct_item_ops = &emu_item_ops,
+    .ct_owner = THIS_MODULE,
+};
+
+static int emu_set_inst_name(struct usb_function_instance *fi, const char *name) {
+    struct rtl8811au_emu_opts *opts = container_of(fi, struct rtl8811au_emu_opts, func_inst);
+
+    if (strscpy(opts->name, name, sizeof(opts->name)) < 0)
+        return -ENAMETOOLONG;
+    return 0;
+}
+
+static void emu_free_inst(struct usb_function_instance *fi) {
+    kfree(container_of(fi, struct rtl8811au_emu_opts, func_inst));
+}
+
+static struct usb_function_instance *emu_alloc_inst(void) {
+    struct rtl8811au_emu_opts *opts;
+
+    opts = kzalloc(sizeof(*opts), GFP_KERNEL);
+    if (!opts)
+        return ERR_PTR(-ENOMEM);
+    opts->func_inst.set_inst_name = emu_set_inst_name;
+    opts->func_inst.free_func_inst = emu_free_inst;
+    config_group_init_type_name(&opts->func_inst.group, "", &emu_func_type);
+    return &opts->func_inst;
+}
+
+DECLARE_USB_FUNCTION(rtl8811au, emu_alloc_inst, emu_alloc_func);
+
+// --- Module ---
+static int __init rtl8811au_emu_init(void) {
+    int ret;
+
+    emu_debugfs = debugfs_create_dir("rtl8811au_emu", NULL);
+    ret = usb_function_register(&rtl8811auusb_func);
+    if (ret)
+        debugfs_remove_recursive(emu_debugfs);
+    return ret;
+}
+
+static void __exit rtl8811au_emu_exit(void) {
+    // configfs holds a module reference for every instance, so none are left here
+    usb_function_unregister(&rtl8811auusb_func);
+    debugfs_remove_recursive(emu_debugfs);
+}
+
+module_init(rtl8811au_emu_init);
+module_exit(rtl8811au_emu_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("Emulated RTL8811AU USB device for testing rtl8811au without hardware");